@@ -37,6 +37,14 @@
 #define ID_DAP_JTAG_Sequence            0x14
 #define ID_DAP_JTAG_Configure           0x15
 #define ID_DAP_JTAG_IDCODE              0x16
+#define ID_DAP_SWO_Transport            0x17
+#define ID_DAP_SWO_Mode                 0x18
+#define ID_DAP_SWO_Baudrate             0x19
+#define ID_DAP_SWO_Control              0x1A
+#define ID_DAP_SWO_Status               0x1B
+#define ID_DAP_SWO_Data                 0x1C
+#define ID_DAP_QueueCommands            0x7E
+#define ID_DAP_ExecuteCommands          0x7F
 
 // DAP Vendor Command IDs
 #define ID_DAP_Vendor0                  0x80
@@ -72,6 +80,19 @@
 #define ID_DAP_Vendor30                 0x9E
 #define ID_DAP_Vendor31                 0x9F
 
+// DAP Vendor Command IDs (implemented)
+#define ID_DAP_Vendor_ReadMemory        ID_DAP_Vendor0
+#define ID_DAP_Vendor_WriteMemory       ID_DAP_Vendor1
+#define ID_DAP_Vendor_TuneClock         ID_DAP_Vendor2
+#define ID_DAP_Vendor_Profile           ID_DAP_Vendor3
+#define ID_DAP_Vendor_TransferStat      ID_DAP_Vendor4
+#define ID_DAP_Vendor_TransferTimeout   ID_DAP_Vendor5
+#define ID_DAP_Vendor_RTT               ID_DAP_Vendor6
+#define ID_DAP_Vendor_PC_Sample         ID_DAP_Vendor7
+#define ID_DAP_Vendor_Watch             ID_DAP_Vendor8
+#define ID_DAP_Vendor_ReadCoreRegs      ID_DAP_Vendor9
+#define ID_DAP_Vendor_WriteCoreRegs     ID_DAP_Vendor10
+
 #define ID_DAP_Invalid                  0xFF
 
 // DAP Status Code
@@ -86,6 +107,7 @@
 #define DAP_ID_DEVICE_VENDOR            5
 #define DAP_ID_DEVICE_NAME              6
 #define DAP_ID_CAPABILITIES             0xF0
+#define DAP_ID_SWO_BUFFER_SIZE          0xFD
 #define DAP_ID_PACKET_COUNT             0xFE
 #define DAP_ID_PACKET_SIZE              0xFF
 
@@ -122,6 +144,17 @@
 #define DAP_TRANSFER_ERROR              (1<<3)
 #define DAP_TRANSFER_MISMATCH           (1<<4)
 
+// DAP SWO Trace Mode
+#define DAP_SWO_OFF                     0
+#define DAP_SWO_UART                    1
+#define DAP_SWO_MANCHESTER              2
+
+// DAP SWO Trace Status
+#define DAP_SWO_CAPTURE_ACTIVE          (1<<0)
+#define DAP_SWO_CAPTURE_PAUSED          (1<<1)
+#define DAP_SWO_STREAM_ERROR            (1<<6)
+#define DAP_SWO_BUFFER_OVERRUN          (1<<7)
+
 
 // Debug Port Register Addresses
 #define DP_IDCODE                       0x00    // IDCODE Register (SW Read only)
@@ -132,6 +165,47 @@
 #define DP_RESEND                       0x08    // Resend (SW Read Only)
 #define DP_RDBUFF                       0x0C    // Read Buffer (Read Only)
 
+// MEM-AP Register Addresses
+#define AP_CSW                          0x00    // Control and Status Word
+#define AP_TAR                          0x04    // Transfer Address
+#define AP_DRW                          0x0C    // Data Read/Write
+#define AP_BD0                          0x10    // Banked Data 0
+#define AP_BD1                          0x14    // Banked Data 1
+#define AP_BD2                          0x18    // Banked Data 2
+#define AP_BD3                          0x1C    // Banked Data 3
+#define AP_IDR                          0xFC    // Identification Register
+
+// DP CTRL/STAT Register Fields
+#define CTRL_STAT_STICKYORUN            (1<<1)  // Sticky Overrun
+#define CTRL_STAT_STICKYCMP             (1<<4)  // Sticky Compare
+#define CTRL_STAT_STICKYERR             (1<<5)  // Sticky Error
+#define CTRL_STAT_WDATAERR              (1<<7)  // Write Data Error (SW Only)
+#define CTRL_STAT_STICKY_Msk            (CTRL_STAT_STICKYORUN | CTRL_STAT_STICKYCMP | \
+                                         CTRL_STAT_STICKYERR  | CTRL_STAT_WDATAERR)
+
+// DP ABORT Register Fields (SW Only)
+#define ABORT_STKCMPCLR                 (1<<1)  // Clear STICKYCMP
+#define ABORT_STKERRCLR                 (1<<2)  // Clear STICKYERR
+#define ABORT_WDERRCLR                  (1<<3)  // Clear WDATAERR
+#define ABORT_ORUNERRCLR                (1<<4)  // Clear STICKYORUN
+
+// DP SELECT Register Fields
+#define SELECT_APSEL_Pos                24      // AP Select
+#define SELECT_APBANKSEL_Msk            0xF0    // AP Bank Select
+
+// MEM-AP CSW Register Fields
+#define CSW_SIZE_Msk                    0x07    // Access Size
+#define CSW_SIZE8                       0x00    // Access Size: 8-bit
+#define CSW_SIZE16                      0x01    // Access Size: 16-bit
+#define CSW_SIZE32                      0x02    // Access Size: 32-bit
+#define CSW_ADDRINC_Msk                 0x30    // Auto Address Increment Mode
+#define CSW_ADDRINC_OFF                 0x00    // Auto Address Increment: Off
+#define CSW_ADDRINC_SINGLE              0x10    // Auto Address Increment: Single
+#define CSW_ADDRINC_PACKED              0x20    // Auto Address Increment: Packed
+
+// MEM-AP TAR auto-increment is only guaranteed within a 1KB block
+#define TAR_AUTOINC_BLOCK               0x400
+
 // JTAG IR Codes
 #define JTAG_ABORT                      0x08
 #define JTAG_DPACC                      0x0A
@@ -153,11 +227,19 @@ typedef struct {
   uint8_t     debug_port;                       // Debug Port
   uint8_t     fast_clock;                       // Fast Clock Flag
   uint32_t   clock_delay;                       // Clock Delay
+#if (DAP_CYCLE_COUNTER != 0)
+  uint32_t   clock_edge;                        // Cycle Counter at last Clock Edge
+#endif
   struct {                                      // Transfer Configuration
     uint8_t   idle_cycles;                      // Idle cycles after transfer
     uint16_t  retry_count;                      // Number of retries after WAIT response
     uint16_t  match_retry;                      // Number of retries if read value does not match
     uint32_t  match_mask;                       // Match Mask
+#if (DAP_WAIT_TIMEOUT != 0)
+    uint32_t  wait_timeout;                     // WAIT time budget in cycles (0 = use retry_count)
+    uint32_t  wait_backoff;                     // Maximum backoff between WAIT retries in cycles
+    uint32_t  wait_start;                       // Cycle Counter at start of the WAIT time budget
+#endif
   } transfer;
 #if (DAP_SWD != 0)
   struct {                                      // SWD Configuration
@@ -176,29 +258,167 @@ typedef struct {
 #endif
   } jtag_dev;
 #endif
+#if (DAP_REG_CACHE != 0)
+  struct {                                      // DP/AP Register Cache
+    uint8_t   select_valid;                     // DP SELECT value is known
+    uint8_t   jtag_index;                       // JTAG device the cache belongs to
+    uint32_t  select;                           // DP SELECT
+    struct {
+      uint8_t   flags;                          // Cache flags (MEM-AP, CSW/TAR valid, CSW verified)
+      uint32_t  csw;                            // MEM-AP CSW
+      uint32_t  tar;                            // MEM-AP TAR
+    } ap[DAP_REG_CACHE];
+  } reg_cache;
+#endif
 } DAP_Data_t;
 
 extern          DAP_Data_t DAP_Data;            // DAP Data
 extern volatile uint8_t    DAP_TransferAbort;   // Transfer Abort Flag
 
+// WAIT retry histogram buckets: 0, 1, 2-3, 4-7, .. 32-63, 64 and more retries
+#define DAP_STAT_WAIT_NUM       8
+
+// SWD/JTAG Transfer Statistics
+typedef struct {
+  uint32_t  wait[DAP_STAT_WAIT_NUM];            // Accesses by number of WAIT retries
+  uint32_t  wait_expired;                       // Accesses out of WAIT retries
+  uint32_t  fault;                              // FAULT responses
+  uint32_t  parity;                             // Parity errors
+  uint32_t  protocol;                           // Protocol errors (invalid ACK)
+  uint32_t  mismatch;                           // Reads out of match retries
+} DAP_TransferStat_t;
+
+extern          DAP_TransferStat_t DAP_TransferStat;  // Transfer Statistics
+
+#if (DAP_REG_CACHE != 0)
+// Host view of DP SELECT and one MEM-AP (saved around background accesses)
+typedef struct {
+  uint32_t  select;                             // DP SELECT
+  uint8_t   flags;                              // MEM-AP cache flags
+  uint32_t  csw;                                // MEM-AP CSW
+  uint32_t  tar;                                // MEM-AP TAR
+} DAP_HostState_t;
+#endif
+
+#if (DAP_PROFILE != 0)
+// Profiled command IDs: standard 0x00..0x1F, vendor 0x80..0x9F and one entry for others
+#define DAP_PROFILE_NUM         65
+#define DAP_PROFILE_IDX(id)     (((id) < 0x20) ? (id) : \
+                                 (((id) >= ID_DAP_Vendor0) && ((id) <= ID_DAP_Vendor31)) ? ((id) - 0x60) : 64)
+#define DAP_PROFILE_ID(idx)     (((idx) < 0x20) ? (idx) : ((idx) < 64) ? ((idx) + 0x60) : ID_DAP_Invalid)
+
+// DAP Command Profile (DWT cycle counter)
+typedef struct {
+  uint32_t    end;                              // Cycle Counter at end of last command
+  uint32_t    wait;                             // WAIT responses of current command
+  uint32_t    error;                            // Failed responses of current command
+  uint64_t    idle;                             // Cycles between commands
+  struct {
+    uint32_t  count;                            // Invocations
+    uint32_t  max;                              // Maximum cycles
+    uint32_t  wait;                             // WAIT responses
+    uint32_t  error;                            // FAULT, protocol and parity errors
+    uint64_t  cycles;                           // Total cycles
+  } cmd[DAP_PROFILE_NUM];
+} DAP_Profile_t;
+
+extern          DAP_Profile_t DAP_Profile;      // DAP Command Profile
+#endif
+
 
 // Functions
-extern void     SWJ_Sequence    (uint32_t count, uint8_t *data);
-extern void     JTAG_Sequence   (uint32_t info,  uint8_t *tdi, uint8_t *tdo);
+extern uint32_t SWJ_Sequence    (uint32_t count, uint8_t *data);
+extern uint32_t JTAG_Sequence   (uint32_t info,  uint8_t *tdi, uint8_t *tdo);
 extern void     JTAG_IR         (uint32_t ir);
 extern uint32_t JTAG_ReadIDCode (void);
 extern void     JTAG_WriteAbort (uint32_t data);
 extern uint8_t  JTAG_Transfer   (uint32_t request, uint32_t *data);
 extern uint8_t  SWD_Transfer    (uint32_t request, uint32_t *data);
+extern void     SWD_TransferSelect (void);
 
 extern void     Delayms         (uint32_t delay);
+extern void     DAP_SetClock    (uint32_t clock);
+#if (DAP_REG_CACHE != 0)
+extern void     DAP_CacheInvalidate (void);
+#else
+#define         DAP_CacheInvalidate()
+#endif
+
+extern uint8_t  DAP_TransferRegister      (uint32_t request, uint32_t *data);
+extern uint8_t  DAP_TransferRegisterBlock (uint32_t request, uint8_t *data, uint32_t count, uint32_t *done);
+extern uint8_t  DAP_MemoryCSW   (uint32_t ap, uint32_t size, uint32_t *csw);
+extern uint8_t  DAP_ReadMemory  (uint32_t ap, uint32_t csw, uint32_t addr, uint8_t *data, uint32_t count, uint32_t *done);
+extern uint8_t  DAP_WriteMemory (uint32_t ap, uint32_t csw, uint32_t addr, uint8_t *data, uint32_t count, uint32_t *done);
+
+#if (DAP_REG_CACHE != 0)
+extern uint32_t DAP_SaveHostState    (uint32_t ap, DAP_HostState_t *state);
+extern uint8_t  DAP_RestoreHostState (uint32_t ap, DAP_HostState_t *state);
+#endif
+
+extern uint32_t RTT_Control     (uint8_t *request, uint8_t *response);
+extern uint32_t PC_SampleCommand (uint8_t *request, uint8_t *response);
+extern uint32_t WatchCommand    (uint8_t *request, uint8_t *response);
 
-extern uint32_t DAP_ProcessVendorCommand (uint8_t *request, uint8_t *response);
+extern uint32_t SWO_Transport   (uint8_t *request, uint8_t *response);
+extern uint32_t SWO_Mode        (uint8_t *request, uint8_t *response);
+extern uint32_t SWO_Baudrate    (uint8_t *request, uint8_t *response);
+extern uint32_t SWO_Control     (uint8_t *request, uint8_t *response);
+extern uint32_t SWO_Status      (uint8_t *response);
+extern uint32_t SWO_Data        (uint8_t *request, uint8_t *response);
+
+extern uint32_t DAP_ProcessVendorCommand  (uint8_t *request, uint8_t *response);
+extern uint32_t DAP_ContinueVendorCommand (uint8_t *response);
 
 extern uint32_t DAP_ProcessCommand (uint8_t *request, uint8_t *response);
+extern uint32_t DAP_ExecuteCommand (uint8_t *request, uint8_t *response);
 extern void     DAP_Setup (void);
 
+#if (DAP_PROFILE != 0)
+extern void     DAP_ProfileReset (void);
+
+// Count failed SWD/JTAG transfer response of the current command
+static __inline void DAP_ProfileAck (uint32_t ack) {
+  if (ack != DAP_TRANSFER_OK) {
+    if (ack == DAP_TRANSFER_WAIT) {
+      DAP_Profile.wait++;
+    } else {
+      DAP_Profile.error++;
+    }
+  }
+}
+#endif
+
+// Start WAIT time budget shared by the following transfers (one command)
+#if (DAP_WAIT_TIMEOUT != 0)
+#define DAP_TransferBudgetStart()       (DAP_Data.transfer.wait_start = DWT->CYCCNT)
+#else
+#define DAP_TransferBudgetStart()
+#endif
+
 // Configurable delay for clock generation
+#if (DAP_CYCLE_COUNTER != 0)
+// Wait until delay cycles after the previous clock edge (DWT cycle counter)
+// After idle time or a missed deadline pacing restarts with a full delay.
+#define DELAY_SLOW_CYCLES       1       // Number of cycles for one delay unit
+static __forceinline void PIN_DELAY_SLOW (uint32_t delay) {
+  uint32_t edge;
+
+  edge = DAP_Data.clock_edge;
+  if ((DWT->CYCCNT - edge) > delay) {
+    edge = DWT->CYCCNT;                 // Restart pacing after idle time
+  }
+  while ((DWT->CYCCNT - edge) < delay);
+  DAP_Data.clock_edge = edge + delay;
+}
+
+// Wait delay cycles from now (time delays, independent of clock pacing)
+static __forceinline void DELAY_SLOW (uint32_t delay) {
+  uint32_t start;
+
+  start = DWT->CYCCNT;
+  while ((DWT->CYCCNT - start) < delay);
+}
+#else
 #define DELAY_SLOW_CYCLES       3       // Number of cycles for one iteration
 static __forceinline void PIN_DELAY_SLOW (uint32_t delay) {
   volatile int32_t count;
@@ -207,11 +427,18 @@ static __forceinline void PIN_DELAY_SLOW (uint32_t delay) {
   while (--count);
 }
 
+#define DELAY_SLOW(delay)       PIN_DELAY_SLOW(delay)
+#endif
+
 // Fixed delay for fast clock generation
 #define DELAY_FAST_CYCLES       0       // Number of cycles
 static __forceinline void PIN_DELAY_FAST (void) {
 //__nop();
 }
 
+// Maximum SWD/JTAG clock for given delay cycles
+#define MAX_SWJ_CLOCK(delay_cycles) \
+  (CPU_CLOCK/2 / (IO_PORT_WRITE_CYCLES + delay_cycles))
+
 
 #endif  /* __DAP_H__ */
@@ -0,0 +1,53 @@
+/* CMSIS-DAP Interface Firmware
+ * Copyright (c) 2009-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef DAP_QUEUE_H
+#define DAP_QUEUE_H
+
+#include <stdint.h>
+#include "ring.h"
+
+#if (!RING_SIZE_OK(DAP_PACKET_COUNT))
+#error "DAP Packet Count must be a power of two"
+#endif
+
+// DAP packet queue of a USB transport (HID or bulk)
+// Requests are received and responses are sent in place from the USB interrupt.
+// The transport provides the function which starts sending a response.
+// DAP_config.h must be included before this file.
+typedef struct {
+  Ring_t            request_ring;               // Request  Buffer Ring
+  Ring_t            response_ring;              // Response Buffer Ring
+  volatile uint8_t  response_idle;              // Response Buffer Idle  Flag
+  volatile uint8_t  spare_full;                 // Spare Buffer holds a request
+  uint8_t           vendor_pending;             // Vendor command continues
+  uint32_t        (*send)(uint8_t *buf, uint32_t len);  // Start sending response
+  uint8_t           request [DAP_PACKET_COUNT][DAP_PACKET_SIZE];  // Request  Buffer
+  uint8_t           response[DAP_PACKET_COUNT][DAP_PACKET_SIZE];  // Response Buffer
+  uint16_t          response_len[DAP_PACKET_COUNT];               // Response Length
+  uint8_t           spare[DAP_PACKET_SIZE];                       // Spare Request Buffer
+} DAP_Queue_t;
+
+// Called from the USB interrupt
+extern void     DAP_QueueInit         (DAP_Queue_t *queue, uint32_t (*send)(uint8_t *buf, uint32_t len));
+extern uint8_t *DAP_QueueRequestBuf   (DAP_Queue_t *queue);
+extern void     DAP_QueueReceived     (DAP_Queue_t *queue, uint8_t *buf, uint32_t len);
+extern uint32_t DAP_QueueResponseSent (DAP_Queue_t *queue, uint8_t **buf);
+
+// Called from the main loop
+extern uint32_t DAP_QueueBusy         (DAP_Queue_t *queue);
+extern uint32_t DAP_QueueProcess      (DAP_Queue_t *queue);
+
+#endif /* DAP_QUEUE_H */
@@ -0,0 +1,74 @@
+/* CMSIS-DAP Interface Firmware
+ * Copyright (c) 2009-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef RING_H
+#define RING_H
+
+#include <stdint.h>
+
+// Single producer / single consumer ring
+// The producer only advances 'in' and the consumer only advances 'out'. Both
+// counters run freely, so the number of used slots is always (in - out) and
+// full/empty need no extra flags. The ring size must be a power of two.
+// The CMSIS core header (__DMB) must be included before this file.
+typedef struct {
+  volatile uint32_t in;                         // Producer counter
+  volatile uint32_t out;                        // Consumer counter
+} Ring_t;
+
+// Ring size check for #if
+#define RING_SIZE_OK(size)      (((size) != 0) && (((size) & ((size) - 1)) == 0))
+
+// Slot index of a counter value
+#define RING_IDX(cnt, size)     ((cnt) & ((size) - 1))
+
+
+// Reset ring to empty (no producer or consumer may be active)
+static __inline void ring_init (Ring_t *ring) {
+  ring->in  = 0;
+  ring->out = 0;
+}
+
+// Number of used slots
+// Slot contents are read only after the counters (barrier).
+static __inline uint32_t ring_count (Ring_t *ring) {
+  uint32_t n;
+
+  n = ring->in - ring->out;
+  __DMB();
+  return (n);
+}
+
+// Number of free slots
+//   size: ring size
+static __inline uint32_t ring_free (Ring_t *ring, uint32_t size) {
+  return (size - ring_count(ring));
+}
+
+// Producer: publish slots after writing them
+// Slot contents are visible before the counter (barrier).
+static __inline void ring_put (Ring_t *ring, uint32_t num) {
+  __DMB();
+  ring->in += num;
+}
+
+// Consumer: release slots after reading them
+// Slot reads complete before the producer may reuse the slots (barrier).
+static __inline void ring_get (Ring_t *ring, uint32_t num) {
+  __DMB();
+  ring->out += num;
+}
+
+#endif /* RING_H */
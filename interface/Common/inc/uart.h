@@ -59,6 +59,9 @@ typedef struct {
   UART_FlowControl   FlowControl;
 } UART_Configuration;
 
+/* Receive handler: called from the UART interrupt with the received data */
+typedef void (*UART_ReceiveHandler)(uint8_t *data, uint32_t size);
+
 /*-----------------------------------------------------------------------------
  * FUNCTION PROTOTYPES
  *----------------------------------------------------------------------------*/
@@ -72,5 +75,6 @@ extern int32_t  uart_get_configuration           (UART_Configuration *config);
 extern int32_t  uart_write_free                  (void);
 extern int32_t  uart_write_data                  (uint8_t *data, uint16_t size);
 extern int32_t  uart_read_data                   (uint8_t *data, uint16_t size);
+extern int32_t  uart_set_receive_handler         (UART_ReceiveHandler handler);
 
 #endif /* __UART_H */
@@ -38,15 +38,22 @@
 
 // Clock Macros
 
-#define MAX_SWJ_CLOCK(delay_cycles) \
-  (CPU_CLOCK/2 / (IO_PORT_WRITE_CYCLES + delay_cycles))
-
+#if (DAP_CYCLE_COUNTER != 0)
+#define CLOCK_DELAY(swj_clock) \
+ ((CPU_CLOCK/2 + (swj_clock - 1)) / swj_clock)
+#else
 #define CLOCK_DELAY(swj_clock) \
  ((CPU_CLOCK/2 / swj_clock) - IO_PORT_WRITE_CYCLES)
+#endif
 
 
          DAP_Data_t DAP_Data;           // DAP Data
 volatile uint8_t    DAP_TransferAbort;  // Trasfer Abort Flag
+         DAP_TransferStat_t DAP_TransferStat;  // Transfer Statistics
+
+#if (DAP_PROFILE != 0)
+         DAP_Profile_t DAP_Profile;     // DAP Command Profile
+#endif
 
 
 #ifdef DAP_VENDOR
@@ -109,10 +116,21 @@ static uint8_t DAP_Info(uint8_t id, uint8_t *info) {
 #endif
       break;
     case DAP_ID_CAPABILITIES:
-      info[0] = ((DAP_SWD  != 0) ? (1 << 0) : 0) |
-                ((DAP_JTAG != 0) ? (1 << 1) : 0);
+      info[0] = ((DAP_SWD  != 0)   ? (1 << 0) : 0) |
+                ((DAP_JTAG != 0)   ? (1 << 1) : 0) |
+                ((SWO_UART != 0)   ? (1 << 2) : 0) |
+                ((SWO_STREAM != 0) ? (1 << 6) : 0);
       length = 1;
       break;
+#if (SWO_UART != 0)
+    case DAP_ID_SWO_BUFFER_SIZE:
+      info[0] = (uint8_t)(SWO_BUFFER_SIZE >>  0);
+      info[1] = (uint8_t)(SWO_BUFFER_SIZE >>  8);
+      info[2] = (uint8_t)(SWO_BUFFER_SIZE >> 16);
+      info[3] = (uint8_t)(SWO_BUFFER_SIZE >> 24);
+      length = 4;
+      break;
+#endif
     case DAP_ID_PACKET_SIZE:
       info[0] = (uint8_t)(DAP_PACKET_SIZE >> 0);
       info[1] = (uint8_t)(DAP_PACKET_SIZE >> 8);
@@ -154,34 +172,402 @@ static __inline uint32_t TIMER_EXPIRED (void) {
 
 
 // Delay for specified time
+// A transfer abort request ends the delay after the current millisecond.
 //    delay:  delay time in ms
 void Delayms(uint32_t delay) {
-  delay *= (CPU_CLOCK/1000 + (DELAY_SLOW_CYCLES-1)) / DELAY_SLOW_CYCLES;
-  PIN_DELAY_SLOW(delay);
+  while (delay-- && !DAP_TransferAbort) {
+    DELAY_SLOW((CPU_CLOCK/1000 + (DELAY_SLOW_CYCLES-1)) / DELAY_SLOW_CYCLES);
+  }
+}
+
+
+// DP/AP Register Cache
+
+#if (DAP_REG_CACHE != 0)
+
+#define REG_CACHE_MEM_AP        (1<<0)  // Access Port is a MEM-AP (DRW accessed)
+#define REG_CACHE_CSW           (1<<1)  // CSW value is known
+#define REG_CACHE_TAR           (1<<2)  // TAR value is known
+#define REG_CACHE_INC           (1<<3)  // CSW size and increment read back as written
+
+// Invalidate DP/AP register cache
+void DAP_CacheInvalidate (void) {
+  uint32_t n;
+
+  DAP_Data.reg_cache.select_valid = 0;
+  for (n = 0; n < DAP_REG_CACHE; n++) {
+    DAP_Data.reg_cache.ap[n].flags = 0;
+  }
+}
+
+// Get cache index of the selected Access Port
+//   return: AP cache index or DAP_REG_CACHE if selected AP is not cached
+static uint32_t DAP_CacheAP (void) {
+  uint32_t apsel;
+
+  if (DAP_Data.reg_cache.select_valid == 0) {
+    return (DAP_REG_CACHE);
+  }
+  apsel = DAP_Data.reg_cache.select >> SELECT_APSEL_Pos;
+  if (apsel >= DAP_REG_CACHE) {
+    return (DAP_REG_CACHE);
+  }
+  return (apsel);
+}
+
+// Check if a DP/AP register write can be skipped
+//   request: A[3:2] RnW APnDP
+//   data:    DATA[31:0]
+//   return:  1 = register already holds the value, 0 = transfer required
+static uint32_t DAP_CacheHit (uint32_t request, uint32_t data) {
+  uint32_t addr;
+  uint32_t flags;
+  uint32_t n;
+
+  addr = request & (DAP_TRANSFER_A2 | DAP_TRANSFER_A3);
+
+  if ((request & DAP_TRANSFER_APnDP) == 0) {
+    // DP register
+    if (addr == DP_SELECT) {
+      return (DAP_Data.reg_cache.select_valid && (DAP_Data.reg_cache.select == data));
+    }
+    return (0);
+  }
+
+  // AP register (only MEM-AP CSW and TAR are shadowed)
+  n = DAP_CacheAP();
+  if (n == DAP_REG_CACHE) return (0);
+  flags = DAP_Data.reg_cache.ap[n].flags;
+  if ((flags & REG_CACHE_MEM_AP) == 0) return (0);
+
+  addr |= DAP_Data.reg_cache.select & SELECT_APBANKSEL_Msk;
+  switch (addr) {
+    case AP_CSW:
+      return ((flags & REG_CACHE_CSW) && (DAP_Data.reg_cache.ap[n].csw == data));
+    case AP_TAR:
+      return ((flags & REG_CACHE_TAR) && (DAP_Data.reg_cache.ap[n].tar == data));
+  }
+  return (0);
+}
+
+// Track MEM-AP TAR auto-increment after a DRW access
+//   n:      AP cache index
+//   return: none
+static void DAP_CacheIncrementTAR (uint32_t n) {
+  uint32_t csw;
+  uint32_t tar;
+
+  DAP_Data.reg_cache.ap[n].flags |= REG_CACHE_MEM_AP;
+  if ((DAP_Data.reg_cache.ap[n].flags & REG_CACHE_INC) == 0) {
+    // MEM-AP may not implement the written size or increment mode
+    DAP_Data.reg_cache.ap[n].flags &= ~REG_CACHE_TAR;
+    return;
+  }
+
+  csw = DAP_Data.reg_cache.ap[n].csw;
+  switch (csw & CSW_ADDRINC_Msk) {
+    case CSW_ADDRINC_OFF:
+      return;
+    case CSW_ADDRINC_SINGLE:
+      if ((csw & CSW_SIZE_Msk) <= CSW_SIZE32) {
+        tar = DAP_Data.reg_cache.ap[n].tar + (1 << (csw & CSW_SIZE_Msk));
+        // Increment across a 1KB boundary is implementation defined
+        if (((tar ^ DAP_Data.reg_cache.ap[n].tar) & ~(TAR_AUTOINC_BLOCK - 1)) == 0) {
+          DAP_Data.reg_cache.ap[n].tar = tar;
+          return;
+        }
+      }
+      break;
+  }
+  DAP_Data.reg_cache.ap[n].flags &= ~REG_CACHE_TAR;
+}
+
+// Update DP/AP register cache after a transfer
+//   request: A[3:2] RnW APnDP
+//   data:    DATA[31:0] (value written by write transfers)
+//   ack:     transfer acknowledge
+//   return:  none
+static void DAP_CacheUpdate (uint32_t request, uint32_t data, uint32_t ack) {
+  uint32_t addr;
+  uint32_t n;
+
+  if (ack != DAP_TRANSFER_OK) {
+    if (ack != DAP_TRANSFER_WAIT) {
+      // FAULT or protocol error: register state is unknown
+      DAP_CacheInvalidate();
+    }
+    return;
+  }
+
+  addr = request & (DAP_TRANSFER_A2 | DAP_TRANSFER_A3);
+
+  if ((request & DAP_TRANSFER_APnDP) == 0) {
+    // DP register
+    if ((request & DAP_TRANSFER_RnW) == 0) {
+      switch (addr) {
+        case DP_ABORT:
+        case DP_CTRL_STAT:
+          // Abort or power request may reset the debug domain
+          DAP_CacheInvalidate();
+          break;
+        case DP_SELECT:
+          DAP_Data.reg_cache.select       = data;
+          DAP_Data.reg_cache.select_valid = 1;
+          break;
+      }
+    }
+    return;
+  }
+
+  // AP register
+  n = DAP_CacheAP();
+  if (n == DAP_REG_CACHE) return;
+
+  addr |= DAP_Data.reg_cache.select & SELECT_APBANKSEL_Msk;
+  if (addr == AP_DRW) {
+    DAP_CacheIncrementTAR(n);
+    return;
+  }
+  if ((request & DAP_TRANSFER_RnW) == 0) {
+    switch (addr) {
+      case AP_CSW:
+        // Size and increment stay verified while they are written unchanged
+        if ((DAP_Data.reg_cache.ap[n].csw ^ data) & (CSW_SIZE_Msk | CSW_ADDRINC_Msk)) {
+          DAP_Data.reg_cache.ap[n].flags &= ~REG_CACHE_INC;
+        }
+        DAP_Data.reg_cache.ap[n].csw    = data;
+        DAP_Data.reg_cache.ap[n].flags |= REG_CACHE_CSW;
+        break;
+      case AP_TAR:
+        DAP_Data.reg_cache.ap[n].tar    = data;
+        DAP_Data.reg_cache.ap[n].flags |= REG_CACHE_TAR;
+        break;
+    }
+  }
+}
+
+// Check if the written CSW of the selected MEM-AP needs to be read back
+//   return: 1 = CSW size and increment are not verified yet
+static uint32_t DAP_CacheCheckCSW (void) {
+  uint32_t n;
+
+  n = DAP_CacheAP();
+  if (n == DAP_REG_CACHE) return (0);
+  return ((DAP_Data.reg_cache.ap[n].flags & (REG_CACHE_CSW | REG_CACHE_INC)) == REG_CACHE_CSW);
+}
+
+// Verify the written CSW of the selected MEM-AP with its read back value
+// TAR auto-increment is only tracked when size and increment read back as
+// written, otherwise TAR is invalidated after each DRW access.
+//   data:   CSW read back value
+//   return: none
+static void DAP_CacheVerifyCSW (uint32_t data) {
+  uint32_t n;
+
+  n = DAP_CacheAP();
+  if (n == DAP_REG_CACHE) return;
+  if ((DAP_Data.reg_cache.ap[n].flags & REG_CACHE_CSW) &&
+     (((DAP_Data.reg_cache.ap[n].csw ^ data) & (CSW_SIZE_Msk | CSW_ADDRINC_Msk)) == 0)) {
+    DAP_Data.reg_cache.ap[n].flags |= REG_CACHE_INC;
+  }
+}
+
+// SWD Transfer I/O through DP/AP register cache
+//   request: A[3:2] RnW APnDP
+//   data:    DATA[31:0]
+//   return:  ACK[2:0]
+#if (DAP_SWD != 0)
+static uint8_t SWD_TransferCache (uint32_t request, uint32_t *data) {
+  uint8_t ack;
+
+  if (((request & DAP_TRANSFER_RnW) == 0) && DAP_CacheHit(request, *data)) {
+    return (DAP_TRANSFER_OK);
+  }
+  ack = SWD_Transfer(request, data);
+  DAP_CacheUpdate(request, (data != NULL) ? *data : 0, ack);
+  return (ack);
+}
+#endif
+
+// JTAG Transfer I/O through DP/AP register cache
+//   request: A[3:2] RnW APnDP
+//   data:    DATA[31:0]
+//   return:  ACK[2:0]
+#if (DAP_JTAG != 0)
+static uint8_t JTAG_TransferCache (uint32_t request, uint32_t *data) {
+  uint8_t ack;
+
+  if (DAP_Data.reg_cache.jtag_index != DAP_Data.jtag_dev.index) {
+    // Each device on the scan chain has its own DP
+    DAP_CacheInvalidate();
+    DAP_Data.reg_cache.jtag_index = DAP_Data.jtag_dev.index;
+  }
+  if (((request & DAP_TRANSFER_RnW) == 0) && DAP_CacheHit(request, *data)) {
+    return (DAP_TRANSFER_OK);
+  }
+  ack = JTAG_Transfer(request, data);
+  DAP_CacheUpdate(request, (data != NULL) ? *data : 0, ack);
+  return (ack);
+}
+#endif
+
+#else
+
+#define SWD_TransferCache       SWD_Transfer
+#define JTAG_TransferCache      JTAG_Transfer
+
+#endif
+
+
+// Record SWD/JTAG access in transfer statistics
+//   ack:     ACK[2:0] of the last response
+//   waits:   number of WAIT responses
+static void DAP_TransferStatAdd (uint32_t ack, uint32_t waits) {
+  uint32_t n;
+
+  // Histogram bucket is the bit length of the retry count
+  for (n = 0; waits && (n < (DAP_STAT_WAIT_NUM - 1)); waits >>= 1) n++;
+  DAP_TransferStat.wait[n]++;
+
+  switch (ack) {
+    case DAP_TRANSFER_OK:
+      break;
+    case DAP_TRANSFER_WAIT:
+      DAP_TransferStat.wait_expired++;
+      break;
+    case DAP_TRANSFER_FAULT:
+      DAP_TransferStat.fault++;
+      break;
+    case DAP_TRANSFER_ERROR:
+      DAP_TransferStat.parity++;
+      break;
+    default:
+      DAP_TransferStat.protocol++;
+      break;
+  }
+}
+
+// Transfer I/O through DP/AP register cache on the given port
+//   port:     DAP_PORT_SWD or DAP_PORT_JTAG (constant after inlining)
+//   request:  A[3:2] RnW APnDP
+//   data:     DATA[31:0]
+//   return:   ACK[2:0]
+static __forceinline uint8_t DAP_TransferIO (uint32_t port, uint32_t request, uint32_t *data) {
+  switch (port) {
+#if (DAP_SWD != 0)
+    case DAP_PORT_SWD:
+      return (SWD_TransferCache(request, data));
+#endif
+#if (DAP_JTAG != 0)
+    case DAP_PORT_JTAG:
+      return (JTAG_TransferCache(request, data));
+#endif
+  }
+  return (0);
+}
+
+// Transfer I/O with WAIT retries
+// Retries until the response is not WAIT, the retry count or time budget
+// expires or the transfer is aborted. The time budget is shared by all
+// transfers of a command (see DAP_TransferBudgetStart). The delay between
+// retries starts at 1us and doubles up to the configured maximum backoff.
+//   port:     DAP_PORT_SWD or DAP_PORT_JTAG (constant after inlining)
+//   request:  A[3:2] RnW APnDP
+//   data:     DATA[31:0]
+//   return:   ACK[2:0]
+static __forceinline uint8_t DAP_TransferRetry (uint32_t port, uint32_t request, uint32_t *data) {
+  uint32_t waits;
+  uint8_t  ack;
+#if (DAP_WAIT_TIMEOUT != 0)
+  uint32_t start;
+  uint32_t edge;
+  uint32_t backoff;
+#endif
+
+  ack = DAP_TransferIO(port, request, data);
+
+#if (DAP_WAIT_TIMEOUT != 0)
+  start   = DAP_Data.transfer.wait_start;
+  backoff = CPU_CLOCK/1000000;
+#endif
+  waits = 0;
+  while (ack == DAP_TRANSFER_WAIT) {
+    waits++;
+    if (DAP_TransferAbort) break;
+#if (DAP_WAIT_TIMEOUT != 0)
+    if (DAP_Data.transfer.wait_timeout) {
+      if ((DWT->CYCCNT - start) >= DAP_Data.transfer.wait_timeout) break;
+      if (DAP_Data.transfer.wait_backoff) {
+        // Back off within the time budget, the target is busy
+        edge = DWT->CYCCNT;
+        while (((DWT->CYCCNT - edge)  < backoff) &&
+               ((DWT->CYCCNT - start) < DAP_Data.transfer.wait_timeout) && !DAP_TransferAbort);
+        backoff <<= 1;
+        if (backoff > DAP_Data.transfer.wait_backoff) {
+          backoff = DAP_Data.transfer.wait_backoff;
+        }
+      }
+    } else
+#endif
+    if (waits > DAP_Data.transfer.retry_count) break;
+    ack = DAP_TransferIO(port, request, data);
+  }
+
+  DAP_TransferStatAdd(ack, waits);
+  return (ack);
+}
+
+// SWD Transfer I/O with WAIT retries
+//   request: A[3:2] RnW APnDP
+//   data:    DATA[31:0]
+//   return:  ACK[2:0]
+#if (DAP_SWD != 0)
+static uint8_t SWD_TransferRetry (uint32_t request, uint32_t *data) {
+  return (DAP_TransferRetry(DAP_PORT_SWD, request, data));
+}
+#endif
+
+// JTAG Transfer I/O with WAIT retries
+//   request: A[3:2] RnW APnDP
+//   data:    DATA[31:0]
+//   return:  ACK[2:0]
+#if (DAP_JTAG != 0)
+static uint8_t JTAG_TransferRetry (uint32_t request, uint32_t *data) {
+  return (DAP_TransferRetry(DAP_PORT_JTAG, request, data));
 }
+#endif
 
 
 // Process Delay command and prepare response
+// A transfer abort request ends the delay early. The abort flag is left for
+// the transfer layer and the delay still reports DAP_OK.
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 static uint32_t DAP_Delay(uint8_t *request, uint8_t *response) {
   uint32_t delay;
+  uint32_t n;
 
   delay  = *(request+0) | (*(request+1) << 8);
-  delay *= (CPU_CLOCK/1000000 + (DELAY_SLOW_CYCLES-1)) / DELAY_SLOW_CYCLES;
 
-  PIN_DELAY_SLOW(delay);
+  // Wait in slices of 1ms which can be aborted
+  while (delay && !DAP_TransferAbort) {
+    n = (delay > 1000) ? 1000 : delay;
+    delay -= n;
+    DELAY_SLOW(n * ((CPU_CLOCK/1000000 + (DELAY_SLOW_CYCLES-1)) / DELAY_SLOW_CYCLES));
+  }
 
   *response = DAP_OK;
-  return (1);
+  return ((2 << 16) | 1);
 }
 
 
 // Process LED command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 static uint32_t DAP_LED(uint8_t *request, uint8_t *response) {
 
   switch (*request) {
@@ -193,21 +579,29 @@ static uint32_t DAP_LED(uint8_t *request, uint8_t *response) {
       break;
     default:
       *response = DAP_ERROR;
-      return (1);
+      return ((2 << 16) | 1);
   }
 
   *response = DAP_OK;
-  return (1);
+  return ((2 << 16) | 1);
 }
 
 
 // Process Connect command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 static uint32_t DAP_Connect(uint8_t *request, uint8_t *response) {
   uint32_t port;
 
+  DAP_CacheInvalidate();
+#if (DAP_WAIT_TIMEOUT != 0)
+  // A new session uses the retry count of Transfer Configure again
+  DAP_Data.transfer.wait_timeout = 0;
+  DAP_Data.transfer.wait_backoff = 0;
+#endif
+
   if (*request == DAP_PORT_AUTODETECT) {
     port = DAP_DEFAULT_PORT;
   } else {
@@ -229,11 +623,11 @@ static uint32_t DAP_Connect(uint8_t *request, uint8_t *response) {
 #endif
     default:
       *response = DAP_PORT_DISABLED;
-      return (1);
+      return ((1 << 16) | 1);
   }
 
   *response = port;
-  return (1);
+  return ((1 << 16) | 1);
 }
 
 
@@ -245,6 +639,7 @@ static uint32_t DAP_Disconnect(uint8_t *response) {
 
   DAP_Data.debug_port = DAP_PORT_DISABLED;
   PORT_OFF();
+  DAP_CacheInvalidate();
 
   *response = DAP_OK;
   return (1);
@@ -257,6 +652,7 @@ static uint32_t DAP_Disconnect(uint8_t *response) {
 //   return:   number of bytes in response
 static uint32_t DAP_ResetTarget(uint8_t *response) {
 
+  DAP_CacheInvalidate();
   *(response+1) = RESET_TARGET();
   *(response+0) = DAP_OK;
   return (2);
@@ -266,7 +662,8 @@ static uint32_t DAP_ResetTarget(uint8_t *response) {
 // Process SWJ Pins command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 #if ((DAP_SWD != 0) || (DAP_JTAG != 0))
 static uint32_t DAP_SWJ_Pins(uint8_t *request, uint8_t *response) {
   uint32_t value;
@@ -280,6 +677,8 @@ static uint32_t DAP_SWJ_Pins(uint8_t *request, uint8_t *response) {
            (*(request+4) << 16) |
            (*(request+5) << 24);
 
+  DAP_CacheInvalidate();
+
   if (select & (1 << DAP_SWJ_SWCLK_TCK)) {
     if (value & (1 << DAP_SWJ_SWCLK_TCK)) {
       PIN_SWCLK_TCK_SET();
@@ -336,30 +735,18 @@ static uint32_t DAP_SWJ_Pins(uint8_t *request, uint8_t *response) {
           (PIN_nRESET_IN()    << DAP_SWJ_nRESET);
 
   *response = (uint8_t)value;
-  return (1);
+  return ((6 << 16) | 1);
 }
 #endif
 
 
-// Process SWJ Clock command and prepare response
-//   request:  pointer to request data
-//   response: pointer to response data
-//   return:   number of bytes in response
+// Set SWD/JTAG clock frequency
+//   clock:  clock frequency in Hz (non-zero)
+//   return: none
 #if ((DAP_SWD != 0) || (DAP_JTAG != 0))
-static uint32_t DAP_SWJ_Clock(uint8_t *request, uint8_t *response) {
-  uint32_t clock;
+void DAP_SetClock(uint32_t clock) {
   uint32_t delay;
 
-  clock = (*(request+0) <<  0) |
-          (*(request+1) <<  8) |
-          (*(request+2) << 16) |
-          (*(request+3) << 24);
-
-  if (clock == 0) {
-    *response = DAP_ERROR;
-    return (1);
-  }
-
   if (clock >= MAX_SWJ_CLOCK(DELAY_FAST_CYCLES)) {
     DAP_Data.fast_clock  = 1;
     DAP_Data.clock_delay = 1;
@@ -367,18 +754,47 @@ static uint32_t DAP_SWJ_Clock(uint8_t *request, uint8_t *response) {
     DAP_Data.fast_clock  = 0;
 
     delay = (CPU_CLOCK/2 + (clock - 1)) / clock;
+#if (DAP_CYCLE_COUNTER == 0)
     if (delay > IO_PORT_WRITE_CYCLES) {
       delay -= IO_PORT_WRITE_CYCLES;
       delay  = (delay + (DELAY_SLOW_CYCLES - 1)) / DELAY_SLOW_CYCLES;
     } else {
       delay  = 1;
     }
+#endif
 
     DAP_Data.clock_delay = delay;
   }
+#if (DAP_SWD != 0)
+  SWD_TransferSelect();
+#endif
+}
+#endif
+
+
+// Process SWJ Clock command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+#if ((DAP_SWD != 0) || (DAP_JTAG != 0))
+static uint32_t DAP_SWJ_Clock(uint8_t *request, uint8_t *response) {
+  uint32_t clock;
+
+  clock = (*(request+0) <<  0) |
+          (*(request+1) <<  8) |
+          (*(request+2) << 16) |
+          (*(request+3) << 24);
+
+  if (clock == 0) {
+    *response = DAP_ERROR;
+    return ((4 << 16) | 1);
+  }
+
+  DAP_SetClock(clock);
 
   *response = DAP_OK;
-  return (1);
+  return ((4 << 16) | 1);
 }
 #endif
 
@@ -386,18 +802,21 @@ static uint32_t DAP_SWJ_Clock(uint8_t *request, uint8_t *response) {
 // Process SWJ Sequence command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 #if ((DAP_SWD != 0) || (DAP_JTAG != 0))
 static uint32_t DAP_SWJ_Sequence(uint8_t *request, uint8_t *response) {
   uint32_t count;
 
+  DAP_TransferAbort = 0;
+
   count = *request++;
   if (count == 0) count = 256;
 
-  SWJ_Sequence(count, request);
+  *response = (SWJ_Sequence(count, request) == count) ? DAP_OK : DAP_ERROR;
+  DAP_CacheInvalidate();
 
-  *response = DAP_OK;
-  return (1);
+  return ((((count + 7) / 8 + 1) << 16) | 1);
 }
 #endif
 
@@ -405,7 +824,8 @@ static uint32_t DAP_SWJ_Sequence(uint8_t *request, uint8_t *response) {
 // Process SWD Configure command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 #if (DAP_SWD != 0)
 static uint32_t DAP_SWD_Configure(uint8_t *request, uint8_t *response) {
   uint8_t value;
@@ -413,10 +833,11 @@ static uint32_t DAP_SWD_Configure(uint8_t *request, uint8_t *response) {
   value = *request;
   DAP_Data.swd_conf.turnaround  = (value & 0x03) + 1;
   DAP_Data.swd_conf.data_phase  = (value & 0x04) ? 1 : 0;
+  SWD_TransferSelect();
 
   *response = DAP_OK;
 
-  return (1);
+  return ((1 << 16) | 1);
 }
 #endif
 
@@ -424,14 +845,15 @@ static uint32_t DAP_SWD_Configure(uint8_t *request, uint8_t *response) {
 // Process SWD Abort command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 #if (DAP_SWD != 0)
 static uint32_t DAP_SWD_Abort(uint8_t *request, uint8_t *response) {
   uint32_t data;
 
   if (DAP_Data.debug_port != DAP_PORT_SWD) {
     *response = DAP_ERROR;
-    return (1);
+    return ((5 << 16) | 1);
   }
 
   // Load data (Ignore DAP index)
@@ -442,9 +864,10 @@ static uint32_t DAP_SWD_Abort(uint8_t *request, uint8_t *response) {
 
   // Write Abort register
   SWD_Transfer(DP_ABORT, &data);
+  DAP_CacheInvalidate();
   *response = DAP_OK;
 
-  return (1);
+  return ((5 << 16) | 1);
 }
 #endif
 
@@ -452,32 +875,71 @@ static uint32_t DAP_SWD_Abort(uint8_t *request, uint8_t *response) {
 // Process JTAG Sequence command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 #if (DAP_JTAG != 0)
 static uint32_t DAP_JTAG_Sequence(uint8_t *request, uint8_t *response) {
   uint32_t sequence_info;
   uint32_t sequence_count;
+  uint32_t request_count;
   uint32_t response_count;
   uint32_t count;
+  uint32_t done;
+  uint8_t *response_head;
+
+  DAP_TransferAbort = 0;
 
+  response_head  = response;
   *response++ = DAP_OK;
+  request_count  = 1;
+
+  DAP_CacheInvalidate();
   response_count = 1;
 
   sequence_count = *request++;
   while (sequence_count--) {
     sequence_info = *request++;
-    JTAG_Sequence(sequence_info, request, response);
     count = sequence_info & JTAG_SEQUENCE_TCK;
     if (count == 0) count = 64;
+    done  = 0;
+    if (*response_head == DAP_OK) {
+      done = JTAG_Sequence(sequence_info, request, response);
+      if (done != count) {
+        // Aborted: TDO data is returned up to the last generated bit
+        *response_head = DAP_ERROR;
+      }
+    }
     count = (count + 7) / 8;
     request += count;
+    request_count += count + 1;
     if (sequence_info & JTAG_SEQUENCE_TDO) {
-      response += count;
-      response_count += count;
+      done = (done + 7) / 8;
+      response += done;
+      response_count += done;
     }
   }
 
-  return (response_count);
+  return ((request_count << 16) | response_count);
+}
+#else
+// Get request length of JTAG Sequence command (JTAG not supported)
+//   request:  pointer to request data
+//   return:   number of bytes in request
+static uint32_t DAP_JTAG_SequenceLength(uint8_t *request) {
+  uint32_t sequence_count;
+  uint32_t request_count;
+  uint32_t count;
+
+  request_count  = 1;
+  sequence_count = *request++;
+  while (sequence_count--) {
+    count = *request & JTAG_SEQUENCE_TCK;
+    if (count == 0) count = 64;
+    count = (count + 7) / 8 + 1;
+    request += count;
+    request_count += count;
+  }
+  return (request_count);
 }
 #endif
 
@@ -485,7 +947,8 @@ static uint32_t DAP_JTAG_Sequence(uint8_t *request, uint8_t *response) {
 // Process JTAG Configure command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 #if (DAP_JTAG != 0)
 static uint32_t DAP_JTAG_Configure(uint8_t *request, uint8_t *response) {
   uint32_t count;
@@ -495,6 +958,7 @@ static uint32_t DAP_JTAG_Configure(uint8_t *request, uint8_t *response) {
 
   count = *request++;
   DAP_Data.jtag_dev.count = count;
+  DAP_CacheInvalidate();
 
   bits = 0;
   for (n = 0; n < count; n++) {
@@ -509,7 +973,7 @@ static uint32_t DAP_JTAG_Configure(uint8_t *request, uint8_t *response) {
   }
 
   *response = DAP_OK;
-  return (1);
+  return (((count + 1) << 16) | 1);
 }
 #endif
 
@@ -517,14 +981,15 @@ static uint32_t DAP_JTAG_Configure(uint8_t *request, uint8_t *response) {
 // Process JTAG IDCODE command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 #if (DAP_JTAG != 0)
 static uint32_t DAP_JTAG_IDCode(uint8_t *request, uint8_t *response) {
   uint32_t data;
 
   if (DAP_Data.debug_port != DAP_PORT_JTAG) {
 err:*response = DAP_ERROR;
-    return (1);
+    return ((1 << 16) | 1);
   }
 
   // Device index (JTAP TAP)
@@ -544,7 +1009,7 @@ err:*response = DAP_ERROR;
   *(response+3) = (uint8_t)(data >> 16);
   *(response+4) = (uint8_t)(data >> 24);
 
-  return (1+4);
+  return ((1 << 16) | (1+4));
 }
 #endif
 
@@ -552,14 +1017,15 @@ err:*response = DAP_ERROR;
 // Process JTAG Abort command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 #if (DAP_JTAG != 0)
 static uint32_t DAP_JTAG_Abort(uint8_t *request, uint8_t *response) {
   uint32_t data;
 
   if (DAP_Data.debug_port != DAP_PORT_JTAG) {
 err:*response = DAP_ERROR;
-    return (1);
+    return ((5 << 16) | 1);
   }
 
   // Device index (JTAP TAP)
@@ -577,9 +1043,10 @@ err:*response = DAP_ERROR;
 
   // Write Abort register
   JTAG_WriteAbort(data);
+  DAP_CacheInvalidate();
   *response = DAP_OK;
 
-  return (1);
+  return ((5 << 16) | 1);
 }
 #endif
 
@@ -587,37 +1054,85 @@ err:*response = DAP_ERROR;
 // Process Transfer Configure command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 static uint32_t DAP_TransferConfigure(uint8_t *request, uint8_t *response) {
 
   DAP_Data.transfer.idle_cycles = *(request+0);
   DAP_Data.transfer.retry_count = *(request+1) | (*(request+2) << 8);
   DAP_Data.transfer.match_retry = *(request+3) | (*(request+4) << 8);
+#if (DAP_SWD != 0)
+  SWD_TransferSelect();
+#endif
 
   *response = DAP_OK;
 
-  return (1);
+  return ((5 << 16) | 1);
+}
+
+
+// Skip DAP Transfer requests
+//   request:  pointer to request data
+//   count:    number of transfer requests to skip
+//   return:   pointer to request data following the skipped requests
+static uint8_t *DAP_SkipTransfer(uint8_t *request, uint32_t count) {
+  uint32_t request_value;
+
+  while (count--) {
+    request_value = *request++;
+    if (((request_value & DAP_TRANSFER_RnW) == 0) || (request_value & DAP_TRANSFER_MATCH_VALUE)) {
+      request += 4;     // Write data or match value
+    }
+  }
+
+  return (request);
+}
+
+
+// Process Dummy Transfer command and prepare response (no debug port)
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+static uint32_t DAP_Dummy_Transfer(uint8_t *request, uint8_t *response) {
+  uint8_t  *request_head;
+  uint32_t  request_count;
+
+  request_head  = request;
+
+  request++;            // Ignore DAP index
+
+  request_count = *request++;
+  request = DAP_SkipTransfer(request, request_count);
+
+  *(response+0) = 0;    // Response count
+  *(response+1) = 0;    // Response value
+
+  return (((request - request_head) << 16) | 2);
 }
 
 
 // Process SWD Transfer command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 #if (DAP_SWD != 0)
 static uint32_t DAP_SWD_Transfer(uint8_t *request, uint8_t *response) {
+  uint8_t  *request_head;
   uint32_t  request_count;
   uint32_t  request_value;
+  uint32_t  request_data;
   uint32_t  response_count;
   uint32_t  response_value;
   uint8_t  *response_head;
   uint32_t  post_read;
   uint32_t  check_write;
-  uint32_t  match_value;
   uint32_t  match_retry;
-  uint32_t  retry;
   uint32_t  data;
 
+  request_head   = request;
+  request_data   = 0;
   response_count = 0;
   response_value = 0;
   response_head  = response;
@@ -631,23 +1146,27 @@ static uint32_t DAP_SWD_Transfer(uint8_t *request, uint8_t *response) {
   request++;            // Ignore DAP index
 
   request_count = *request++;
-  while (request_count--) {
+  while (request_count != 0) {
+    request_count--;
     request_value = *request++;
+    if (((request_value & DAP_TRANSFER_RnW) == 0) || (request_value & DAP_TRANSFER_MATCH_VALUE)) {
+      // Load write data or match value
+      request_data = (*(request+0) <<  0) |
+                     (*(request+1) <<  8) |
+                     (*(request+2) << 16) |
+                     (*(request+3) << 24);
+      request += 4;
+    }
     if (request_value & DAP_TRANSFER_RnW) {
       // Read register
       if (post_read) {
         // Read was posted before
-        retry = DAP_Data.transfer.retry_count;
         if ((request_value & (DAP_TRANSFER_APnDP | DAP_TRANSFER_MATCH_VALUE)) == DAP_TRANSFER_APnDP) {
           // Read previous AP data and post next AP read
-          do {
-            response_value = SWD_Transfer(request_value, &data);
-          } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+          response_value = SWD_TransferRetry(request_value, &data);
         } else {
           // Read previous AP data
-          do {
-            response_value = SWD_Transfer(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
-          } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+          response_value = SWD_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
           post_read = 0;
         }
         if (response_value != DAP_TRANSFER_OK) break;
@@ -659,50 +1178,37 @@ static uint32_t DAP_SWD_Transfer(uint8_t *request, uint8_t *response) {
       }
       if (request_value & DAP_TRANSFER_MATCH_VALUE) {
         // Read with value match
-        match_value = (*(request+0) <<  0) |
-                      (*(request+1) <<  8) |
-                      (*(request+2) << 16) |
-                      (*(request+3) << 24);
-        request += 4;
         match_retry = DAP_Data.transfer.match_retry;
         if (request_value & DAP_TRANSFER_APnDP) {
           // Post AP read
-          retry = DAP_Data.transfer.retry_count;
-          do {
-            response_value = SWD_Transfer(request_value, NULL);
-          } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+          response_value = SWD_TransferRetry(request_value, NULL);
           if (response_value != DAP_TRANSFER_OK) break;
         }
         do {
           // Read register until its value matches or retry counter expires
-          retry = DAP_Data.transfer.retry_count;
-          do {
-            response_value = SWD_Transfer(request_value, &data);
-          } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+          response_value = SWD_TransferRetry(request_value, &data);
           if (response_value != DAP_TRANSFER_OK) break;
-        } while (((data & DAP_Data.transfer.match_mask) != match_value) && match_retry-- && !DAP_TransferAbort);
-        if ((data & DAP_Data.transfer.match_mask) != match_value) {
+        } while (((data & DAP_Data.transfer.match_mask) != request_data) && match_retry-- && !DAP_TransferAbort);
+        if ((data & DAP_Data.transfer.match_mask) != request_data) {
+          if (response_value == DAP_TRANSFER_OK) {
+            DAP_TransferStat.mismatch++;
+          }
           response_value |= DAP_TRANSFER_MISMATCH;
         }
         if (response_value != DAP_TRANSFER_OK) break;
       } else {
         // Normal read
-        retry = DAP_Data.transfer.retry_count;
         if (request_value & DAP_TRANSFER_APnDP) {
           // Read AP register
           if (post_read == 0) {
             // Post AP read
-            do {
-              response_value = SWD_Transfer(request_value, NULL);
-            } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+            response_value = SWD_TransferRetry(request_value, NULL);
             if (response_value != DAP_TRANSFER_OK) break;
             post_read = 1;
           }
         } else {
           // Read DP register
-          do {
-            response_value = SWD_Transfer(request_value, &data);
-          } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+          response_value = SWD_TransferRetry(request_value, &data);
           if (response_value != DAP_TRANSFER_OK) break;
           // Store data
           *response++ = (uint8_t) data;
@@ -716,10 +1222,7 @@ static uint32_t DAP_SWD_Transfer(uint8_t *request, uint8_t *response) {
       // Write register
       if (post_read) {
         // Read previous data
-        retry = DAP_Data.transfer.retry_count;
-        do {
-          response_value = SWD_Transfer(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
-        } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+        response_value = SWD_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
         if (response_value != DAP_TRANSFER_OK) break;
         // Store previous data
         *response++ = (uint8_t) data;
@@ -728,22 +1231,14 @@ static uint32_t DAP_SWD_Transfer(uint8_t *request, uint8_t *response) {
         *response++ = (uint8_t)(data >> 24);
         post_read = 0;
       }
-      // Load data
-      data = (*(request+0) <<  0) |
-             (*(request+1) <<  8) |
-             (*(request+2) << 16) |
-             (*(request+3) << 24);
-      request += 4;
+      data = request_data;
       if (request_value & DAP_TRANSFER_MATCH_MASK) {
         // Write match mask
         DAP_Data.transfer.match_mask = data;
         response_value = DAP_TRANSFER_OK;
       } else {
         // Write DP/AP register
-        retry = DAP_Data.transfer.retry_count;
-        do {
-          response_value = SWD_Transfer(request_value, &data);
-        } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+        response_value = SWD_TransferRetry(request_value, &data);
         if (response_value != DAP_TRANSFER_OK) break;
         check_write = 1;
       }
@@ -755,10 +1250,7 @@ static uint32_t DAP_SWD_Transfer(uint8_t *request, uint8_t *response) {
   if (response_value == DAP_TRANSFER_OK) {
     if (post_read) {
       // Read previous data
-      retry = DAP_Data.transfer.retry_count;
-      do {
-        response_value = SWD_Transfer(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
-      } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+      response_value = SWD_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
       if (response_value != DAP_TRANSFER_OK) goto end;
       // Store previous data
       *response++ = (uint8_t) data;
@@ -767,18 +1259,18 @@ static uint32_t DAP_SWD_Transfer(uint8_t *request, uint8_t *response) {
       *response++ = (uint8_t)(data >> 24);
     } else if (check_write) {
       // Check last write
-      retry = DAP_Data.transfer.retry_count;
-      do {
-        response_value = SWD_Transfer(DP_RDBUFF | DAP_TRANSFER_RnW, NULL);
-      } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+      response_value = SWD_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, NULL);
     }
   }
 
 end:
+  // Skip canceled requests
+  request = DAP_SkipTransfer(request, request_count);
+
   *(response_head+0) = (uint8_t)response_count;
   *(response_head+1) = (uint8_t)response_value;
 
-  return (response - response_head);
+  return (((request - request_head) << 16) | (response - response_head));
 }
 #endif
 
@@ -786,22 +1278,25 @@ end:
 // Process JTAG Transfer command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 #if (DAP_JTAG != 0)
 static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
+  uint8_t  *request_head;
   uint32_t  request_count;
   uint32_t  request_value;
+  uint32_t  request_data;
   uint32_t  request_ir;
   uint32_t  response_count;
   uint32_t  response_value;
   uint8_t  *response_head;
   uint32_t  post_read;
-  uint32_t  match_value;
   uint32_t  match_retry;
-  uint32_t  retry;
   uint32_t  data;
   uint32_t  ir;
 
+  request_head   = request;
+  request_data   = 0;
   response_count = 0;
   response_value = 0;
   response_head  = response;
@@ -814,22 +1309,28 @@ static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
 
   // Device index (JTAP TAP)
   DAP_Data.jtag_dev.index = *request++;
+  request_count = *request++;
   if (DAP_Data.jtag_dev.index >= DAP_Data.jtag_dev.count) goto end;
 
-  request_count = *request++;
-  while (request_count--) {
+  while (request_count != 0) {
+    request_count--;
     request_value = *request++;
     request_ir = (request_value & DAP_TRANSFER_APnDP) ? JTAG_APACC : JTAG_DPACC;
+    if (((request_value & DAP_TRANSFER_RnW) == 0) || (request_value & DAP_TRANSFER_MATCH_VALUE)) {
+      // Load write data or match value
+      request_data = (*(request+0) <<  0) |
+                     (*(request+1) <<  8) |
+                     (*(request+2) << 16) |
+                     (*(request+3) << 24);
+      request += 4;
+    }
     if (request_value & DAP_TRANSFER_RnW) {
       // Read register
       if (post_read) {
         // Read was posted before
-        retry = DAP_Data.transfer.retry_count;
         if ((ir == request_ir) && ((request_value & DAP_TRANSFER_MATCH_VALUE) == 0)) {
           // Read previous data and post next read
-          do {
-            response_value = JTAG_Transfer(request_value, &data);
-          } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+          response_value = JTAG_TransferRetry(request_value, &data);
         } else {
           // Select JTAG chain
           if (ir != JTAG_DPACC) {
@@ -837,9 +1338,7 @@ static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
             JTAG_IR(ir);
           }
           // Read previous data
-          do {
-            response_value = JTAG_Transfer(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
-          } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+          response_value = JTAG_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
           post_read = 0;
         }
         if (response_value != DAP_TRANSFER_OK) break;
@@ -851,11 +1350,6 @@ static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
       }
       if (request_value & DAP_TRANSFER_MATCH_VALUE) {
         // Read with value match
-        match_value = (*(request+0) <<  0) |
-                      (*(request+1) <<  8) |
-                      (*(request+2) << 16) |
-                      (*(request+3) << 24);
-        request += 4;
         match_retry  = DAP_Data.transfer.match_retry;
         // Select JTAG chain
         if (ir != request_ir) {
@@ -863,20 +1357,17 @@ static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
           JTAG_IR(ir);
         }
         // Post DP/AP read
-        retry = DAP_Data.transfer.retry_count;
-        do {
-          response_value = JTAG_Transfer(request_value, NULL);
-        } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+        response_value = JTAG_TransferRetry(request_value, NULL);
         if (response_value != DAP_TRANSFER_OK) break;
         do {
           // Read register until its value matches or retry counter expires
-          retry = DAP_Data.transfer.retry_count;
-          do {
-            response_value = JTAG_Transfer(request_value, &data);
-          } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+          response_value = JTAG_TransferRetry(request_value, &data);
           if (response_value != DAP_TRANSFER_OK) break;
-        } while (((data & DAP_Data.transfer.match_mask) != match_value) && match_retry-- && !DAP_TransferAbort);
-        if ((data & DAP_Data.transfer.match_mask) != match_value) {
+        } while (((data & DAP_Data.transfer.match_mask) != request_data) && match_retry-- && !DAP_TransferAbort);
+        if ((data & DAP_Data.transfer.match_mask) != request_data) {
+          if (response_value == DAP_TRANSFER_OK) {
+            DAP_TransferStat.mismatch++;
+          }
           response_value |= DAP_TRANSFER_MISMATCH;
         }
         if (response_value != DAP_TRANSFER_OK) break;
@@ -889,10 +1380,7 @@ static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
             JTAG_IR(ir);
           }
           // Post DP/AP read
-          retry = DAP_Data.transfer.retry_count;
-          do {
-            response_value = JTAG_Transfer(request_value, NULL);
-          } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+          response_value = JTAG_TransferRetry(request_value, NULL);
           if (response_value != DAP_TRANSFER_OK) break;
           post_read = 1;
         }
@@ -906,10 +1394,7 @@ static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
           JTAG_IR(ir);
         }
         // Read previous data
-        retry = DAP_Data.transfer.retry_count;
-        do {
-          response_value = JTAG_Transfer(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
-        } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+        response_value = JTAG_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
         if (response_value != DAP_TRANSFER_OK) break;
         // Store previous data
         *response++ = (uint8_t) data;
@@ -918,12 +1403,7 @@ static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
         *response++ = (uint8_t)(data >> 24);
         post_read = 0;
       }
-      // Load data
-      data = (*(request+0) <<  0) |
-             (*(request+1) <<  8) |
-             (*(request+2) << 16) |
-             (*(request+3) << 24);
-      request += 4;
+      data = request_data;
       if (request_value & DAP_TRANSFER_MATCH_MASK) {
         // Write match mask
         DAP_Data.transfer.match_mask = data;
@@ -935,10 +1415,7 @@ static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
           JTAG_IR(ir);
         }
         // Write DP/AP register
-        retry = DAP_Data.transfer.retry_count;
-        do {
-          response_value = JTAG_Transfer(request_value, &data);
-        } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+        response_value = JTAG_TransferRetry(request_value, &data);
         if (response_value != DAP_TRANSFER_OK) break;
       }
     }
@@ -954,10 +1431,7 @@ static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
     }
     if (post_read) {
       // Read previous data
-      retry = DAP_Data.transfer.retry_count;
-      do {
-        response_value = JTAG_Transfer(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
-      } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+      response_value = JTAG_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, &data);
       if (response_value != DAP_TRANSFER_OK) goto end;
       // Store previous data
       *response++ = (uint8_t) data;
@@ -966,18 +1440,149 @@ static uint32_t DAP_JTAG_Transfer(uint8_t *request, uint8_t *response) {
       *response++ = (uint8_t)(data >> 24);
     } else {
       // Check last write
-      retry = DAP_Data.transfer.retry_count;
-      do {
-        response_value = JTAG_Transfer(DP_RDBUFF | DAP_TRANSFER_RnW, NULL);
-      } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+      response_value = JTAG_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, NULL);
     }
   }
 
 end:
+  // Skip canceled requests
+  request = DAP_SkipTransfer(request, request_count);
+
   *(response_head+0) = (uint8_t)response_count;
   *(response_head+1) = (uint8_t)response_value;
 
-  return (response - response_head);
+  return (((request - request_head) << 16) | (response - response_head));
+}
+#endif
+
+
+// SWD Transfer block of DP/AP registers
+// A transfer abort request ends the block after the current transfer.
+//   request: A[3:2] RnW APnDP
+//   data:    pointer to register data (4 bytes per transfer, LSB first)
+//   count:   number of transfers
+//   done:    pointer to number of completed transfers
+//   return:  ACK[2:0]
+#if (DAP_SWD != 0)
+static uint32_t SWD_TransferBlock(uint32_t request, uint8_t *data, uint32_t count, uint32_t *done) {
+  uint32_t  response_value;
+  uint32_t  value;
+
+  *done = 0;
+
+  if (request & DAP_TRANSFER_RnW) {
+    // Read register block
+    if (request & DAP_TRANSFER_APnDP) {
+      // Post AP read
+      response_value = SWD_TransferRetry(request, NULL);
+      if (response_value != DAP_TRANSFER_OK) return (response_value);
+    }
+    while (count--) {
+      // Read DP/AP register
+      if ((count == 0) && (request & DAP_TRANSFER_APnDP)) {
+        // Last AP read
+        request = DP_RDBUFF | DAP_TRANSFER_RnW;
+      }
+      response_value = SWD_TransferRetry(request, &value);
+      if (response_value != DAP_TRANSFER_OK) return (response_value);
+      // Store data
+      *data++ = (uint8_t) value;
+      *data++ = (uint8_t)(value >>  8);
+      *data++ = (uint8_t)(value >> 16);
+      *data++ = (uint8_t)(value >> 24);
+      (*done)++;
+      if (DAP_TransferAbort) break;
+    }
+  } else {
+    // Write register block
+    while (count--) {
+      // Load data
+      value = (*(data+0) <<  0) |
+              (*(data+1) <<  8) |
+              (*(data+2) << 16) |
+              (*(data+3) << 24);
+      data += 4;
+      // Write DP/AP register
+      response_value = SWD_TransferRetry(request, &value);
+      if (response_value != DAP_TRANSFER_OK) return (response_value);
+      (*done)++;
+      if (DAP_TransferAbort) break;
+    }
+    // Check last write
+    response_value = SWD_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, NULL);
+  }
+
+  return (response_value);
+}
+#endif
+
+
+// JTAG Transfer block of DP/AP registers
+// A transfer abort request ends the block after the current transfer.
+//   request: A[3:2] RnW APnDP
+//   data:    pointer to register data (4 bytes per transfer, LSB first)
+//   count:   number of transfers
+//   done:    pointer to number of completed transfers
+//   return:  ACK[2:0]
+#if (DAP_JTAG != 0)
+static uint32_t JTAG_TransferBlock(uint32_t request, uint8_t *data, uint32_t count, uint32_t *done) {
+  uint32_t  response_value;
+  uint32_t  value;
+  uint32_t  ir;
+
+  *done = 0;
+
+  // Select JTAG chain
+  ir = (request & DAP_TRANSFER_APnDP) ? JTAG_APACC : JTAG_DPACC;
+  JTAG_IR(ir);
+
+  if (request & DAP_TRANSFER_RnW) {
+    // Post read
+    response_value = JTAG_TransferRetry(request, NULL);
+    if (response_value != DAP_TRANSFER_OK) return (response_value);
+    // Read register block
+    while (count--) {
+      // Read DP/AP register
+      if (count == 0) {
+        // Last read
+        if (ir != JTAG_DPACC) {
+          JTAG_IR(JTAG_DPACC);
+        }
+        request = DP_RDBUFF | DAP_TRANSFER_RnW;
+      }
+      response_value = JTAG_TransferRetry(request, &value);
+      if (response_value != DAP_TRANSFER_OK) return (response_value);
+      // Store data
+      *data++ = (uint8_t) value;
+      *data++ = (uint8_t)(value >>  8);
+      *data++ = (uint8_t)(value >> 16);
+      *data++ = (uint8_t)(value >> 24);
+      (*done)++;
+      if (DAP_TransferAbort) break;
+    }
+  } else {
+    // Write register block
+    while (count--) {
+      // Load data
+      value = (*(data+0) <<  0) |
+              (*(data+1) <<  8) |
+              (*(data+2) << 16) |
+              (*(data+3) << 24);
+      data += 4;
+      // Write DP/AP register
+      response_value = JTAG_TransferRetry(request, &value);
+      if (response_value != DAP_TRANSFER_OK) return (response_value);
+      (*done)++;
+      if (DAP_TransferAbort) break;
+    }
+    // Check last write
+    if (ir != JTAG_DPACC) {
+      JTAG_IR(JTAG_DPACC);
+    }
+    response_value = JTAG_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, NULL);
+  }
+
+  return (response_value);
 }
 #endif
 
@@ -993,8 +1598,6 @@ static uint32_t DAP_SWD_TransferBlock(uint8_t *request, uint8_t *response) {
   uint32_t  response_count;
   uint32_t  response_value;
   uint8_t  *response_head;
-  uint32_t  retry;
-  uint32_t  data;
 
   response_count = 0;
   response_value = 0;
@@ -1012,54 +1615,11 @@ static uint32_t DAP_SWD_TransferBlock(uint8_t *request, uint8_t *response) {
   request_value = *request++;
   if (request_value & DAP_TRANSFER_RnW) {
     // Read register block
-    if (request_value & DAP_TRANSFER_APnDP) {
-      // Post AP read
-      retry = DAP_Data.transfer.retry_count;
-      do {
-        response_value = SWD_Transfer(request_value, NULL);
-      } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
-      if (response_value != DAP_TRANSFER_OK) goto end;
-    }
-    while (request_count--) {
-      // Read DP/AP register
-      if ((request_count == 0) && (request_value & DAP_TRANSFER_APnDP)) {
-        // Last AP read
-        request_value = DP_RDBUFF | DAP_TRANSFER_RnW;
-      }
-      retry = DAP_Data.transfer.retry_count;
-      do {
-        response_value = SWD_Transfer(request_value, &data);
-      } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
-      if (response_value != DAP_TRANSFER_OK) goto end;
-      // Store data
-      *response++ = (uint8_t) data;
-      *response++ = (uint8_t)(data >>  8);
-      *response++ = (uint8_t)(data >> 16);
-      *response++ = (uint8_t)(data >> 24);
-      response_count++;
-    }
+    response_value = SWD_TransferBlock(request_value, response, request_count, &response_count);
+    response += response_count * 4;
   } else {
     // Write register block
-    while (request_count--) {
-      // Load data
-      data = (*(request+0) <<  0) |
-             (*(request+1) <<  8) |
-             (*(request+2) << 16) |
-             (*(request+3) << 24);
-      request += 4;
-      // Write DP/AP register
-      retry = DAP_Data.transfer.retry_count;
-      do {
-        response_value = SWD_Transfer(request_value, &data);
-      } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
-      if (response_value != DAP_TRANSFER_OK) goto end;
-      response_count++;
-    }
-    // Check last write
-    retry = DAP_Data.transfer.retry_count;
-    do {
-      response_value = SWD_Transfer(DP_RDBUFF | DAP_TRANSFER_RnW, NULL);
-    } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+    response_value = SWD_TransferBlock(request_value, request, request_count, &response_count);
   }
 
 end:
@@ -1083,9 +1643,6 @@ static uint32_t DAP_JTAG_TransferBlock(uint8_t *request, uint8_t *response) {
   uint32_t  response_count;
   uint32_t  response_value;
   uint8_t  *response_head;
-  uint32_t  retry;
-  uint32_t  data;
-  uint32_t  ir;
 
   response_count = 0;
   response_value = 0;
@@ -1103,65 +1660,13 @@ static uint32_t DAP_JTAG_TransferBlock(uint8_t *request, uint8_t *response) {
   if (request_count == 0) goto end;
 
   request_value = *request++;
-
-  // Select JTAG chain
-  ir = (request_value & DAP_TRANSFER_APnDP) ? JTAG_APACC : JTAG_DPACC;
-  JTAG_IR(ir);
-
   if (request_value & DAP_TRANSFER_RnW) {
-    // Post read
-    retry = DAP_Data.transfer.retry_count;
-    do {
-      response_value = JTAG_Transfer(request_value, NULL);
-    } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
-    if (response_value != DAP_TRANSFER_OK) goto end;
     // Read register block
-    while (request_count--) {
-      // Read DP/AP register
-      if (request_count == 0) {
-        // Last read
-        if (ir != JTAG_DPACC) {
-          JTAG_IR(JTAG_DPACC);
-        }
-        request_value = DP_RDBUFF | DAP_TRANSFER_RnW;
-      }
-      retry = DAP_Data.transfer.retry_count;
-      do {
-        response_value = JTAG_Transfer(request_value, &data);
-      } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
-      if (response_value != DAP_TRANSFER_OK) goto end;
-      // Store data
-      *response++ = (uint8_t) data;
-      *response++ = (uint8_t)(data >>  8);
-      *response++ = (uint8_t)(data >> 16);
-      *response++ = (uint8_t)(data >> 24);
-      response_count++;
-    }
+    response_value = JTAG_TransferBlock(request_value, response, request_count, &response_count);
+    response += response_count * 4;
   } else {
     // Write register block
-    while (request_count--) {
-      // Load data
-      data = (*(request+0) <<  0) |
-             (*(request+1) <<  8) |
-             (*(request+2) << 16) |
-             (*(request+3) << 24);
-      request += 4;
-      // Write DP/AP register
-      retry = DAP_Data.transfer.retry_count;
-      do {
-        response_value = JTAG_Transfer(request_value, &data);
-      } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
-      if (response_value != DAP_TRANSFER_OK) goto end;
-      response_count++;
-    }
-    // Check last write
-    if (ir != JTAG_DPACC) {
-      JTAG_IR(JTAG_DPACC);
-    }
-    retry = DAP_Data.transfer.retry_count;
-    do {
-      response_value = JTAG_Transfer(DP_RDBUFF | DAP_TRANSFER_RnW, NULL);
-    } while ((response_value == DAP_TRANSFER_WAIT) && retry-- && !DAP_TransferAbort);
+    response_value = JTAG_TransferBlock(request_value, request, request_count, &response_count);
   }
 
 end:
@@ -1174,24 +1679,347 @@ end:
 #endif
 
 
+// Transfer DP/AP register on the connected debug port (with WAIT retries)
+// Posted reads are completed through RDBUFF so that read data is returned directly.
+//   request: A[3:2] RnW APnDP
+//   data:    DATA[31:0]
+//   return:  ACK[2:0]
+uint8_t DAP_TransferRegister(uint32_t request, uint32_t *data) {
+  uint32_t  response_value;
+
+  switch (DAP_Data.debug_port) {
+#if (DAP_SWD != 0)
+    case DAP_PORT_SWD:
+      response_value = SWD_TransferRetry(request, data);
+      if ((response_value == DAP_TRANSFER_OK) &&
+          ((request & (DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW)) == (DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW))) {
+        // Read posted AP data
+        response_value = SWD_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, data);
+      }
+      return (response_value);
+#endif
+#if (DAP_JTAG != 0)
+    case DAP_PORT_JTAG:
+      if (DAP_Data.jtag_dev.index >= DAP_Data.jtag_dev.count) break;
+      JTAG_IR((request & DAP_TRANSFER_APnDP) ? JTAG_APACC : JTAG_DPACC);
+      response_value = JTAG_TransferRetry(request, data);
+      if ((response_value == DAP_TRANSFER_OK) && (request & DAP_TRANSFER_RnW)) {
+        // Read posted DP/AP data
+        if (request & DAP_TRANSFER_APnDP) {
+          JTAG_IR(JTAG_DPACC);
+        }
+        response_value = JTAG_TransferRetry(DP_RDBUFF | DAP_TRANSFER_RnW, data);
+      }
+      return (response_value);
+#endif
+  }
+
+  return (0);
+}
+
+
+// Transfer block of DP/AP registers on the connected debug port (with WAIT retries)
+//   request: A[3:2] RnW APnDP
+//   data:    pointer to register data (4 bytes per transfer, LSB first)
+//   count:   number of transfers
+//   done:    pointer to number of completed transfers
+//   return:  ACK[2:0]
+uint8_t DAP_TransferRegisterBlock(uint32_t request, uint8_t *data, uint32_t count, uint32_t *done) {
+
+  *done = 0;
+  if (count == 0) return (DAP_TRANSFER_OK);
+
+  switch (DAP_Data.debug_port) {
+#if (DAP_SWD != 0)
+    case DAP_PORT_SWD:
+      return (SWD_TransferBlock(request, data, count, done));
+#endif
+#if (DAP_JTAG != 0)
+    case DAP_PORT_JTAG:
+      if (DAP_Data.jtag_dev.index >= DAP_Data.jtag_dev.count) break;
+      return (JTAG_TransferBlock(request, data, count, done));
+#endif
+  }
+
+  return (0);
+}
+
+
+// Select MEM-AP and set its CSW and TAR registers
+// A newly written CSW is read back once, so that the register cache only tracks
+// TAR auto-increment for sizes and increment modes the MEM-AP implements.
+//   ap:      AP index (APSEL)
+//   csw:     CSW value (access size and address increment)
+//   addr:    TAR value
+//   return:  ACK[2:0]
+static uint8_t DAP_MemorySetup(uint32_t ap, uint32_t csw, uint32_t addr) {
+  uint32_t  response_value;
+  uint32_t  data;
+
+  data = ap << SELECT_APSEL_Pos;
+  response_value = DAP_TransferRegister(DP_SELECT, &data);
+  if (response_value != DAP_TRANSFER_OK) return (response_value);
+  response_value = DAP_TransferRegister(DAP_TRANSFER_APnDP | AP_CSW, &csw);
+  if (response_value != DAP_TRANSFER_OK) return (response_value);
+#if (DAP_REG_CACHE != 0)
+  if (DAP_CacheCheckCSW()) {
+    response_value = DAP_TransferRegister(DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_CSW, &data);
+    if (response_value != DAP_TRANSFER_OK) return (response_value);
+    DAP_CacheVerifyCSW(data);
+  }
+#endif
+  return (DAP_TransferRegister(DAP_TRANSFER_APnDP | AP_TAR, &addr));
+}
+
+
+// Read MEM-AP CSW and prepare it for the requested access size
+//   ap:      AP index (APSEL)
+//   size:    access size (0 = 8-bit, 1 = 16-bit, 2 = 32-bit)
+//   csw:     pointer to CSW value (single address increment)
+//   return:  ACK[2:0]
+uint8_t DAP_MemoryCSW(uint32_t ap, uint32_t size, uint32_t *csw) {
+  uint32_t  response_value;
+  uint32_t  data;
+
+  data = ap << SELECT_APSEL_Pos;
+  response_value = DAP_TransferRegister(DP_SELECT, &data);
+  if (response_value != DAP_TRANSFER_OK) return (response_value);
+  response_value = DAP_TransferRegister(DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_CSW, &data);
+  if (response_value != DAP_TRANSFER_OK) return (response_value);
+
+  *csw = (data & ~(CSW_SIZE_Msk | CSW_ADDRINC_Msk)) | size | CSW_ADDRINC_SINGLE;
+
+  return (DAP_TRANSFER_OK);
+}
+
+
+// Narrow accesses read per block (DRW returns them in 32-bit words)
+#define READ_NARROW_BLOCK       16
+
+// Read target memory through MEM-AP
+// TAR is rewritten on each auto-increment block boundary. Narrow accesses are
+// read in blocks into a scratch buffer and their byte lanes are packed into
+// data. A transfer abort request ends the access after the current transfer.
+//   ap:      AP index (APSEL)
+//   csw:     CSW value (access size and address increment)
+//   addr:    start address (aligned to access size)
+//   data:    pointer to data buffer (access size bytes per access)
+//   count:   number of accesses
+//   done:    pointer to number of completed accesses
+//   return:  ACK[2:0]
+uint8_t DAP_ReadMemory(uint32_t ap, uint32_t csw, uint32_t addr, uint8_t *data, uint32_t count, uint32_t *done) {
+  uint8_t   block[4*READ_NARROW_BLOCK];
+  uint32_t  response_value;
+  uint32_t  size;
+  uint32_t  lane;
+  uint32_t  n, m, i, k;
+
+  *done = 0;
+  size  = csw & CSW_SIZE_Msk;
+
+  while (count) {
+    // Accesses up to the next auto-increment block boundary
+    n = (TAR_AUTOINC_BLOCK - (addr & (TAR_AUTOINC_BLOCK - 1))) >> size;
+    if (n > count) n = count;
+    response_value = DAP_MemorySetup(ap, csw, addr);
+    if (response_value != DAP_TRANSFER_OK) return (response_value);
+    if (size < CSW_SIZE32) {
+      // Extract byte lanes of narrow accesses
+      if (n > READ_NARROW_BLOCK) n = READ_NARROW_BLOCK;
+      response_value = DAP_TransferRegisterBlock(DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_DRW, block, n, &m);
+      for (i = 0; i < m; i++) {
+        lane = (addr + (i << size)) & 3;
+        for (k = 0; k < (1U << size); k++) {
+          data[(i << size) + k] = block[(i << 2) + lane + k];
+        }
+      }
+    } else {
+      response_value = DAP_TransferRegisterBlock(DAP_TRANSFER_APnDP | DAP_TRANSFER_RnW | AP_DRW, data, n, &m);
+    }
+    *done += m;
+    if ((response_value != DAP_TRANSFER_OK) || (m != n)) return (response_value);
+    data  += n << size;
+    addr  += n << size;
+    count -= n;
+  }
+
+  return (DAP_TRANSFER_OK);
+}
+
+
+// Write target memory through MEM-AP
+// TAR is rewritten on each auto-increment block boundary. A transfer abort
+// request ends the access after the current transfer.
+//   ap:      AP index (APSEL)
+//   csw:     CSW value (access size and address increment)
+//   addr:    start address (aligned to access size)
+//   data:    pointer to data (packed, 1, 2 or 4 bytes per access)
+//   count:   number of accesses
+//   done:    pointer to number of completed accesses
+//   return:  ACK[2:0]
+uint8_t DAP_WriteMemory(uint32_t ap, uint32_t csw, uint32_t addr, uint8_t *data, uint32_t count, uint32_t *done) {
+  uint32_t  response_value;
+  uint32_t  size;
+  uint32_t  value;
+  uint32_t  n, k;
+
+  *done = 0;
+  size  = csw & CSW_SIZE_Msk;
+
+  while (count && !DAP_TransferAbort) {
+    // Accesses up to the next auto-increment block boundary
+    n = (TAR_AUTOINC_BLOCK - (addr & (TAR_AUTOINC_BLOCK - 1))) >> size;
+    if (n > count) n = count;
+    response_value = DAP_MemorySetup(ap, csw, addr);
+    if (response_value != DAP_TRANSFER_OK) return (response_value);
+    count -= n;
+    while (n--) {
+      // Place data on its byte lanes
+      value = 0;
+      for (k = 0; k < (1U << size); k++) {
+        value |= *data++ << (8 * ((addr + k) & 3));
+      }
+      addr += 1 << size;
+      response_value = DAP_TransferRegister(DAP_TRANSFER_APnDP | AP_DRW, &value);
+      if (response_value != DAP_TRANSFER_OK) return (response_value);
+      (*done)++;
+      if (DAP_TransferAbort) break;
+    }
+  }
+
+  // Check last write
+  return (DAP_TransferRegister(DP_RDBUFF | DAP_TRANSFER_RnW, &value));
+}
+
+
+#if (DAP_REG_CACHE != 0)
+// Read DP CTRL/STAT with the given MEM-AP selected
+//   ap:      AP index (APSEL)
+//   data:    pointer to CTRL/STAT value
+//   return:  ACK[2:0]
+static uint8_t DAP_ReadCtrlStat(uint32_t ap, uint32_t *data) {
+  uint32_t  response_value;
+
+  *data = ap << SELECT_APSEL_Pos;
+  response_value = DAP_TransferRegister(DP_SELECT, data);
+  if (response_value != DAP_TRANSFER_OK) return (response_value);
+  return (DAP_TransferRegister(DP_CTRL_STAT | DAP_TRANSFER_RnW, data));
+}
+
+
+// Save host view of DP SELECT and MEM-AP registers before background accesses
+// The debugger expects SELECT, CSW and TAR unchanged between its commands.
+// Background accesses are only possible while the register cache knows them,
+// so that they can be restored afterwards, and while the DP has no sticky
+// errors, so that errors of the background accesses can be cleared without
+// hiding errors from the debugger.
+//   ap:      AP index (APSEL) used by the background accesses
+//   state:   pointer to saved state
+//   return:  1 = state saved, 0 = state unknown or sticky errors pending
+uint32_t DAP_SaveHostState(uint32_t ap, DAP_HostState_t *state) {
+  uint32_t  data;
+
+  if ((DAP_Data.debug_port == DAP_PORT_DISABLED) ||
+      (DAP_Data.reg_cache.select_valid == 0) || (ap >= DAP_REG_CACHE)) {
+    return (0);
+  }
+  state->select = DAP_Data.reg_cache.select;
+  state->flags  = DAP_Data.reg_cache.ap[ap].flags;
+  state->csw    = DAP_Data.reg_cache.ap[ap].csw;
+  state->tar    = DAP_Data.reg_cache.ap[ap].tar;
+
+  DAP_TransferBudgetStart();
+  if ((DAP_ReadCtrlStat(ap, &data) != DAP_TRANSFER_OK) || (data & CTRL_STAT_STICKY_Msk)) {
+    data = state->select;
+    DAP_TransferRegister(DP_SELECT, &data);
+    return (0);
+  }
+  return (1);
+}
+
+
+// Restore host view of DP SELECT and MEM-AP registers after background accesses
+// Sticky errors are cleared first: DAP_SaveHostState found none, so they were
+// caused by the background accesses.
+//   ap:      AP index (APSEL) used by the background accesses
+//   state:   pointer to saved state
+//   return:  ACK[2:0]
+uint8_t DAP_RestoreHostState(uint32_t ap, DAP_HostState_t *state) {
+  uint32_t  response_value;
+  uint32_t  data;
+
+  response_value = DAP_ReadCtrlStat(ap, &data);
+  if (response_value != DAP_TRANSFER_OK) return (response_value);
+  if (data & CTRL_STAT_STICKY_Msk) {
+    switch (DAP_Data.debug_port) {
+#if (DAP_SWD != 0)
+      case DAP_PORT_SWD:
+        data = ABORT_STKCMPCLR | ABORT_STKERRCLR | ABORT_WDERRCLR | ABORT_ORUNERRCLR;
+        response_value = DAP_TransferRegister(DP_ABORT, &data);
+        break;
+#endif
+#if (DAP_JTAG != 0)
+      case DAP_PORT_JTAG:
+        // Sticky flags of the JTAG-DP are cleared by writing one
+        response_value = DAP_TransferRegister(DP_CTRL_STAT, &data);
+        break;
+#endif
+    }
+    if (response_value != DAP_TRANSFER_OK) return (response_value);
+  }
+
+  if (state->flags & (REG_CACHE_CSW | REG_CACHE_TAR)) {
+    data = ap << SELECT_APSEL_Pos;
+    response_value = DAP_TransferRegister(DP_SELECT, &data);
+    if (response_value != DAP_TRANSFER_OK) return (response_value);
+    if (state->flags & REG_CACHE_CSW) {
+      data = state->csw;
+      response_value = DAP_TransferRegister(DAP_TRANSFER_APnDP | AP_CSW, &data);
+      if (response_value != DAP_TRANSFER_OK) return (response_value);
+    }
+    if (state->flags & REG_CACHE_TAR) {
+      data = state->tar;
+      response_value = DAP_TransferRegister(DAP_TRANSFER_APnDP | AP_TAR, &data);
+      if (response_value != DAP_TRANSFER_OK) return (response_value);
+    }
+  }
+  data = state->select;
+  return (DAP_TransferRegister(DP_SELECT, &data));
+}
+#endif
+
+
 // Process DAP Vendor command and prepare response
 // Default function (can be overridden)
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
 __weak uint32_t DAP_ProcessVendorCommand(uint8_t *request, uint8_t *response) {
   *response = ID_DAP_Invalid;
-  return (1);
+  return ((1 << 16) | 1);
+}
+
+
+// Continue DAP Vendor command which spans several response packets
+// Default function (can be overridden)
+//   response: pointer to response data
+//   return:   number of bytes in response (0 when no response is pending)
+__weak uint32_t DAP_ContinueVendorCommand(uint8_t *response) {
+  return (0);
 }
 
 
 // Process DAP command and prepare response
 //   request:  pointer to request data
 //   response: pointer to response data
-//   return:   number of bytes in response
-uint32_t DAP_ProcessCommand(uint8_t *request, uint8_t *response) {
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+static uint32_t DAP_Command(uint8_t *request, uint8_t *response) {
   uint32_t num;
 
+  DAP_TransferBudgetStart();
+
   if ((*request >= ID_DAP_Vendor0) && (*request <= ID_DAP_Vendor31)) {
     return DAP_ProcessVendorCommand(request, response);
   }
@@ -1202,7 +2030,7 @@ uint32_t DAP_ProcessCommand(uint8_t *request, uint8_t *response) {
     case ID_DAP_Info:
       num = DAP_Info(*request, response+1);
       *response = num;
-      return (2 + num);
+      return ((2 << 16) + 2 + num);
     case ID_DAP_LED:
       num = DAP_LED(request, response);
       break;
@@ -1231,10 +2059,18 @@ uint32_t DAP_ProcessCommand(uint8_t *request, uint8_t *response) {
       break;
 #else
     case ID_DAP_SWJ_Pins:
+      *response = DAP_ERROR;
+      num = (6 << 16) | 1;
+      break;
     case ID_DAP_SWJ_Clock:
+      *response = DAP_ERROR;
+      num = (4 << 16) | 1;
+      break;
     case ID_DAP_SWJ_Sequence:
       *response = DAP_ERROR;
-      return (2);
+      num = (*request == 0) ? 256 : *request;
+      num = (((num + 7) / 8 + 1) << 16) | 1;
+      break;
 #endif
 
 #if (DAP_SWD != 0)
@@ -1244,7 +2080,7 @@ uint32_t DAP_ProcessCommand(uint8_t *request, uint8_t *response) {
 #else
     case ID_DAP_SWD_Configure:
       *response = DAP_ERROR;
-      return (2);
+      return ((2 << 16) | 2);
 #endif
 
 #if (DAP_JTAG != 0)
@@ -1259,10 +2095,38 @@ uint32_t DAP_ProcessCommand(uint8_t *request, uint8_t *response) {
       break;
 #else
     case ID_DAP_JTAG_Sequence:
+      *response = DAP_ERROR;
+      num = (DAP_JTAG_SequenceLength(request) << 16) | 1;
+      break;
     case ID_DAP_JTAG_Configure:
+      *response = DAP_ERROR;
+      num = ((*request + 1) << 16) | 1;
+      break;
     case ID_DAP_JTAG_IDCODE:
       *response = DAP_ERROR;
-      return (2);
+      num = (1 << 16) | 1;
+      break;
+#endif
+
+#if (SWO_UART != 0)
+    case ID_DAP_SWO_Transport:
+      num = SWO_Transport(request, response);
+      break;
+    case ID_DAP_SWO_Mode:
+      num = SWO_Mode(request, response);
+      break;
+    case ID_DAP_SWO_Baudrate:
+      num = SWO_Baudrate(request, response);
+      break;
+    case ID_DAP_SWO_Control:
+      num = SWO_Control(request, response);
+      break;
+    case ID_DAP_SWO_Status:
+      num = SWO_Status(response);
+      break;
+    case ID_DAP_SWO_Data:
+      num = SWO_Data(request, response);
+      break;
 #endif
 
     case ID_DAP_TransferConfigure:
@@ -1282,9 +2146,7 @@ uint32_t DAP_ProcessCommand(uint8_t *request, uint8_t *response) {
           break;
 #endif
         default:
-          *(response+0) = 0;    // Response count
-          *(response+1) = 0;    // Response value
-          num = 2;
+          num = DAP_Dummy_Transfer(request, response);
       }
       break;
 
@@ -1306,6 +2168,13 @@ uint32_t DAP_ProcessCommand(uint8_t *request, uint8_t *response) {
           *(response+2) = 0;    // Response value
           num = 3;
       }
+      if (*(request+3) & DAP_TRANSFER_RnW) {
+        // Read register block
+        num |= 4 << 16;
+      } else {
+        // Write register block
+        num |= (4 + ((*(request+1) | (*(request+2) << 8)) * 4)) << 16;
+      }
       break;
 
     case ID_DAP_WriteABORT:
@@ -1322,16 +2191,108 @@ uint32_t DAP_ProcessCommand(uint8_t *request, uint8_t *response) {
 #endif
         default:
           *response = DAP_ERROR;
-          return (2);
+          return ((6 << 16) | 2);
       }
       break;
 
     default:
       *(response-1) = ID_DAP_Invalid;
-      return (1);
+      return ((1 << 16) | 1);
+  }
+
+  return ((1 << 16) + 1 + num);
+}
+
+
+#if (DAP_PROFILE != 0)
+// Reset DAP command profile
+void DAP_ProfileReset(void) {
+  memset(&DAP_Profile, 0, sizeof(DAP_Profile));
+  DAP_Profile.end = DWT->CYCCNT;
+}
+#endif
+
+
+// Process DAP command and prepare response
+// With profiling the cycles, WAIT and failed responses are added to the
+// command ID and the time since the previous command to the idle time.
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t DAP_ProcessCommand(uint8_t *request, uint8_t *response) {
+#if (DAP_PROFILE != 0)
+  uint32_t num;
+  uint32_t start;
+  uint32_t cycles;
+  uint32_t idx;
+
+  idx   = DAP_PROFILE_IDX(*request);
+  start = DWT->CYCCNT;
+  DAP_Profile.idle += start - DAP_Profile.end;
+  DAP_Profile.wait  = 0;
+  DAP_Profile.error = 0;
+
+  num = DAP_Command(request, response);
+
+  DAP_Profile.end = DWT->CYCCNT;
+  cycles = DAP_Profile.end - start;
+  DAP_Profile.cmd[idx].count++;
+  DAP_Profile.cmd[idx].cycles += cycles;
+  if (DAP_Profile.cmd[idx].max < cycles) {
+    DAP_Profile.cmd[idx].max = cycles;
+  }
+  DAP_Profile.cmd[idx].wait  += DAP_Profile.wait;
+  DAP_Profile.cmd[idx].error += DAP_Profile.error;
+
+  return (num);
+#else
+  return DAP_Command(request, response);
+#endif
+}
+
+
+// Execute DAP command (process request and prepare response)
+// Multiple commands packed with ID_DAP_ExecuteCommands are processed in sequence
+// and their responses are concatenated into a single response packet. Vendor
+// commands with responses spanning several packets are rejected there.
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t DAP_ExecuteCommand(uint8_t *request, uint8_t *response) {
+  uint32_t cnt;
+  uint32_t num;
+  uint32_t n;
+
+  if (*request == ID_DAP_ExecuteCommands) {
+    *response++ = *request++;
+    cnt = *request++;
+    *response++ = (uint8_t)cnt;
+    num = (2 << 16) | 2;
+    while (cnt--) {
+      switch (*request) {
+        // Vendor responses which span several packets can not be nested
+        case ID_DAP_Vendor_ReadMemory:   n = 9; break;
+        case ID_DAP_Vendor_Profile:      n = 1; break;
+        case ID_DAP_Vendor_ReadCoreRegs: n = 6; break;
+        default:                         n = 0; break;
+      }
+      if (n) {
+        *(response+0) = *request;
+        *(response+1) = DAP_ERROR;
+        n = ((1 + n) << 16) | 2;
+      } else {
+        n = DAP_ProcessCommand(request, response);
+      }
+      num += n;
+      request  += (uint16_t)(n >> 16);
+      response += (uint16_t) n;
+    }
+    return (num);
   }
 
-  return (1 + num);
+  return DAP_ProcessCommand(request, response);
 }
 
 
@@ -1345,13 +2306,29 @@ void DAP_Setup(void) {
     DAP_Data.transfer.retry_count = 100;
     //DAP_Data.transfer.match_retry = 0;
     //DAP_Data.transfer.match_mask  = 0x000000;
+#if (DAP_WAIT_TIMEOUT != 0)
+    //DAP_Data.transfer.wait_timeout = 0;
+    //DAP_Data.transfer.wait_backoff = 0;
+#endif
 #if (DAP_SWD != 0)
     DAP_Data.swd_conf.turnaround  = 1;
     //DAP_Data.swd_conf.data_phase  = 0;
+    SWD_TransferSelect();
 #endif
 #if (DAP_JTAG != 0)
     //DAP_Data.jtag_dev.count = 0;
 #endif
+    DAP_CacheInvalidate();
+#if ((DAP_CYCLE_COUNTER != 0) || (DAP_PROFILE != 0) || (DAP_WAIT_TIMEOUT != 0) || \
+     (DAP_PC_SAMPLE != 0) || (DAP_WATCH != 0))
+    // Enable DWT cycle counter for clock generation, profiling, WAIT timeout,
+    // PC sampling and the watcher poll interval
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+#if (DAP_PROFILE != 0)
+    DAP_ProfileReset();
+#endif
 
   DAP_SETUP();  // Device specific setup
 }
@@ -0,0 +1,231 @@
+/* CMSIS-DAP Interface Firmware
+ * Copyright (c) 2009-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "DAP_config.h"
+#include "DAP.h"
+#include "DAP_queue.h"
+
+// DAP packet queue
+// The USB interrupt produces requests and consumes responses, the main loop
+// consumes requests and produces responses. Each direction is a single
+// producer / single consumer ring, so the two sides share no locks.
+
+#define PACKET_IDX(cnt)         RING_IDX(cnt, DAP_PACKET_COUNT)
+
+
+// Initialize queue (USB interface initialized or configured)
+//   queue:   pointer to queue
+//   send:    function which starts sending a response (0 = endpoint busy)
+//   return:  none
+void DAP_QueueInit (DAP_Queue_t *queue, uint32_t (*send)(uint8_t *buf, uint32_t len)) {
+  ring_init(&queue->request_ring);
+  ring_init(&queue->response_ring);
+  queue->response_idle  = 1;
+  queue->spare_full     = 0;
+  queue->vendor_pending = 0;
+  queue->send           = send;
+}
+
+
+// Get buffer for the next request (request reception starts)
+// When all buffers are in use the request is received into the spare buffer,
+// so a Transfer Abort still reaches a long running command. Any other request
+// waits there until a buffer is released and further requests stay in the
+// endpoint (NAK).
+//   queue:   pointer to queue
+//   return:  pointer to request buffer or NULL when no buffer is free
+uint8_t *DAP_QueueRequestBuf (DAP_Queue_t *queue) {
+  if (queue->spare_full) {
+    return (NULL);      // Spare buffer is in use
+  }
+  if (ring_free(&queue->request_ring, DAP_PACKET_COUNT) == 0) {
+    return (queue->spare);
+  }
+  return (queue->request[PACKET_IDX(queue->request_ring.in)]);
+}
+
+
+// Queue received request
+// Transfer Abort is handled at once and does not take a buffer.
+//   queue:   pointer to queue
+//   buf:     pointer to request (as returned by DAP_QueueRequestBuf)
+//   len:     number of bytes received
+//   return:  none
+void DAP_QueueReceived (DAP_Queue_t *queue, uint8_t *buf, uint32_t len) {
+  if (len == 0) return;
+  if (buf[0] == ID_DAP_TransferAbort) {
+    DAP_TransferAbort = 1;
+    return;
+  }
+  if (buf == queue->spare) {
+    queue->spare_full = 1;  // Queued when a buffer is released
+    return;
+  }
+  // Request was received in place into the request buffer
+  ring_put(&queue->request_ring, 1);
+}
+
+
+// Release sent response and get the next one
+//   queue:   pointer to queue
+//   buf:     pointer to next response
+//   return:  number of bytes in next response (0 = none, endpoint idle)
+uint32_t DAP_QueueResponseSent (DAP_Queue_t *queue, uint8_t **buf) {
+  uint32_t n;
+
+  // Called without a response in flight (HID idle report update from SOF)
+  if (queue->response_idle) {
+    return (0);
+  }
+
+  // Release sent response
+  ring_get(&queue->response_ring, 1);
+
+  if (ring_count(&queue->response_ring)) {
+    n = PACKET_IDX(queue->response_ring.out);
+    *buf = queue->response[n];
+    return (queue->response_len[n]);
+  }
+
+  queue->response_idle = 1;
+  return (0);
+}
+
+
+// Check for DAP requests in progress
+//   queue:   pointer to queue
+//   return:  1 when requests are pending or a vendor command continues
+uint32_t DAP_QueueBusy (DAP_Queue_t *queue) {
+  return (ring_count(&queue->request_ring) || queue->spare_full || queue->vendor_pending);
+}
+
+
+// Start sending the oldest response when the endpoint is idle
+// Following responses are sent from the USB interrupt, so the next command
+// executes while the host collects this one. The request from the spare
+// buffer is queued once a buffer is free.
+//   queue:   pointer to queue
+//   return:  none
+static void DAP_QueueStartResponse (DAP_Queue_t *queue) {
+  uint32_t n;
+
+  if (queue->response_idle && ring_count(&queue->response_ring)) {
+    // The USB interrupt must not see the response in flight before the
+    // endpoint has it, otherwise an SOF update would release it unsent.
+    __disable_irq();
+    queue->response_idle = 0;
+    n = PACKET_IDX(queue->response_ring.out);
+    if (!queue->send(queue->response[n], queue->response_len[n])) {
+      queue->response_idle = 1;   // Endpoint busy, retry on next call
+    }
+    __enable_irq();
+  }
+
+  // Reception is stopped while the spare buffer is full
+  if (queue->spare_full && ring_free(&queue->request_ring, DAP_PACKET_COUNT)) {
+    memcpy(queue->request[PACKET_IDX(queue->request_ring.in)], queue->spare, DAP_PACKET_SIZE);
+    ring_put(&queue->request_ring, 1);
+    queue->spare_full = 0;
+  }
+}
+
+
+// Get buffer for the next response
+//   queue:   pointer to queue
+//   return:  pointer to response buffer or NULL when all buffers are in use
+static uint8_t *DAP_QueueResponseBuf (DAP_Queue_t *queue) {
+  if (ring_free(&queue->response_ring, DAP_PACKET_COUNT) == 0) {
+    return (NULL);
+  }
+  return (queue->response[PACKET_IDX(queue->response_ring.in)]);
+}
+
+
+// Send prepared response to host
+// The response stays in the response buffer until it is transmitted.
+//   queue:   pointer to queue
+//   len:     number of bytes in response
+//   return:  none
+static void DAP_QueueSendResponse (DAP_Queue_t *queue, uint32_t len) {
+  queue->response_len[PACKET_IDX(queue->response_ring.in)] = len;
+  ring_put(&queue->response_ring, 1);
+  DAP_QueueStartResponse(queue);
+}
+
+
+// Process DAP packets of the queue
+// Vendor commands which span several response packets are continued first.
+// Packets marked with ID_DAP_QueueCommands are deferred until a non-queued
+// packet arrives (or all buffers are full) and then executed as
+// ID_DAP_ExecuteCommands, so the host can fill all buffers in one burst.
+//   queue:   pointer to queue
+//   return:  1 when a packet was processed, 0 when idle
+uint32_t DAP_QueueProcess (DAP_Queue_t *queue) {
+  uint8_t  *request;
+  uint8_t  *response;
+  uint32_t  num;
+  uint32_t  n;
+
+  DAP_QueueStartResponse(queue);
+
+  // Wait for space in response buffer
+  response = DAP_QueueResponseBuf(queue);
+  if (response == NULL) {
+    return (0);
+  }
+
+  // Continue vendor command which spans several response packets
+  if (queue->vendor_pending) {
+    num = DAP_ContinueVendorCommand(response);
+    if (num) {
+      DAP_QueueSendResponse(queue, num);
+      return (1);
+    }
+    queue->vendor_pending = 0;
+  }
+
+  // Process pending requests
+  num = ring_count(&queue->request_ring);
+  if (num == 0) {
+    return (0);
+  }
+
+  // Defer queued commands until a non-queued packet arrives
+  for (n = 0; queue->request[PACKET_IDX(queue->request_ring.out + n)][0] == ID_DAP_QueueCommands; ) {
+    if (++n == num) {
+      if (num == DAP_PACKET_COUNT) {
+        break;  // Execute queue when buffer is full
+      }
+      return (0);
+    }
+  }
+  request = queue->request[PACKET_IDX(queue->request_ring.out)];
+  if (request[0] == ID_DAP_QueueCommands) {
+    request[0] = ID_DAP_ExecuteCommands;
+  }
+
+  // Process DAP Command and prepare response
+  queue->vendor_pending = (request[0] >= ID_DAP_Vendor0) &&
+                          (request[0] <= ID_DAP_Vendor31);
+  num = DAP_ExecuteCommand(request, response);
+
+  // Release request buffer
+  ring_get(&queue->request_ring, 1);
+
+  DAP_QueueSendResponse(queue, (uint16_t)num);
+  return (1);
+}
@@ -0,0 +1,809 @@
+/* CMSIS-DAP Interface Firmware
+ * Copyright (c) 2009-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "DAP_config.h"
+#include "DAP.h"
+
+
+// Memory accesses of the given size per response packet (4 bytes header)
+#define READ_MEMORY_MAX(size)   ((DAP_PACKET_SIZE - 4) >> (size))
+
+// Pending Read Memory command
+static struct {
+  uint8_t   ap;                                 // AP index
+  uint8_t   active;                             // Read is pending
+  uint32_t  csw;                                // MEM-AP CSW
+  uint32_t  addr;                               // Next address
+  uint32_t  count;                              // Remaining accesses
+} ReadMemory;
+
+// Target debug registers used for core register access
+#define DHCSR                   0xE000EDF0      // Debug Halting Control and Status Register
+#define DCRSR                   0xE000EDF4      // Debug Core Register Selector Register
+#define DCRDR                   0xE000EDF8      // Debug Core Register Data Register
+#define DHCSR_S_REGRDY          (1 << 16)       // Core register transfer completed
+#define DCRSR_REGWnR            (1 << 16)       // Core register write
+#define DCRSR_REGSEL_Msk        0x7F            // Core register selector
+#define CORE_REG_RETRY          100             // S_REGRDY polls per register
+
+// Pending Read Core Registers command
+static struct {
+  uint8_t   ap;                                 // AP index
+  uint8_t   active;                             // Read is pending
+  uint8_t   regsel;                             // Register selector for mask bit 0
+  uint32_t  csw;                                // MEM-AP CSW
+  uint32_t  mask;                               // Remaining registers
+} ReadCoreRegs;
+
+
+// Read block of memory into one response packet
+//   response: pointer to response data
+//   return:   number of bytes in response
+static uint32_t ReadMemoryPacket(uint8_t *response) {
+  uint32_t  response_value;
+  uint32_t  size;
+  uint32_t  count;
+  uint32_t  done;
+
+  size  = ReadMemory.csw & CSW_SIZE_Msk;
+  count = ReadMemory.count;
+  if (count > READ_MEMORY_MAX(size)) {
+    count = READ_MEMORY_MAX(size);
+  }
+
+  if (DAP_TransferAbort) {
+    response_value = 0;
+    done = 0;
+  } else {
+    response_value = DAP_ReadMemory(ReadMemory.ap, ReadMemory.csw, ReadMemory.addr,
+                                    response + 4, count, &done);
+  }
+
+  ReadMemory.addr  += done << size;
+  ReadMemory.count -= done;
+  if ((response_value != DAP_TRANSFER_OK) || (ReadMemory.count == 0)) {
+    ReadMemory.active = 0;
+  }
+
+  done <<= size;
+  *(response+0) = ID_DAP_Vendor_ReadMemory;
+  *(response+1) = (uint8_t)(done >> 0);
+  *(response+2) = (uint8_t)(done >> 8);
+  *(response+3) = (uint8_t) response_value;
+
+  return (4 + done);
+}
+
+
+// Process Read Memory command and prepare response
+// Data which does not fit into the response is returned in following packets.
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response
+static uint32_t DAP_ReadMemoryCommand(uint8_t *request, uint8_t *response) {
+  uint32_t  response_value;
+  uint32_t  size;
+  uint32_t  addr;
+  uint32_t  len;
+
+  DAP_TransferAbort = 0;
+  ReadMemory.active = 0;
+
+  addr = (*(request+1) <<  0) |
+         (*(request+2) <<  8) |
+         (*(request+3) << 16) |
+         (*(request+4) << 24);
+  len  = (*(request+5) <<  0) |
+         (*(request+6) <<  8) |
+         (*(request+7) << 16) |
+         (*(request+8) << 24);
+  size = *(request+9);
+
+  if ((size > CSW_SIZE32) || (addr & ((1 << size) - 1)) || (len & ((1 << size) - 1))) {
+    response_value = DAP_TRANSFER_ERROR;
+    goto end;
+  }
+
+  response_value = DAP_MemoryCSW(*request, size, &ReadMemory.csw);
+  if (response_value != DAP_TRANSFER_OK) goto end;
+
+  ReadMemory.ap     = *request;
+  ReadMemory.addr   = addr;
+  ReadMemory.count  = len >> size;
+  ReadMemory.active = 1;
+
+  return (ReadMemoryPacket(response - 1) - 1);
+
+end:
+  *(response+0) = 0;
+  *(response+1) = 0;
+  *(response+2) = (uint8_t)response_value;
+
+  return (3);
+}
+
+
+// Process Write Memory command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+static uint32_t DAP_WriteMemoryCommand(uint8_t *request, uint8_t *response) {
+  uint32_t  response_value;
+  uint32_t  size;
+  uint32_t  addr;
+  uint32_t  len;
+  uint32_t  csw;
+  uint32_t  done;
+
+  DAP_TransferAbort = 0;
+  done = 0;
+
+  addr = (*(request+1) <<  0) |
+         (*(request+2) <<  8) |
+         (*(request+3) << 16) |
+         (*(request+4) << 24);
+  size = *(request+5);
+  len  = (*(request+6) <<  0) |
+         (*(request+7) <<  8);
+
+  if ((size > CSW_SIZE32) || (addr & ((1 << size) - 1)) || (len & ((1 << size) - 1)) ||
+      (len > (DAP_PACKET_SIZE - 9))) {
+    response_value = DAP_TRANSFER_ERROR;
+    goto end;
+  }
+
+  response_value = DAP_MemoryCSW(*request, size, &csw);
+  if (response_value != DAP_TRANSFER_OK) goto end;
+
+  response_value = DAP_WriteMemory(*request, csw, addr, request + 8, len >> size, &done);
+  done <<= size;
+
+end:
+  if (len > (DAP_PACKET_SIZE - 9)) {
+    len = DAP_PACKET_SIZE - 9;          // Invalid length: data ends with the packet
+  }
+  *(response+0) = (uint8_t)(done >> 0);
+  *(response+1) = (uint8_t)(done >> 8);
+  *(response+2) = (uint8_t) response_value;
+
+  return (((8 + len) << 16) | 3);
+}
+
+
+// Wait until the core register transfer has completed
+//   ap:       AP index
+//   csw:      MEM-AP CSW
+//   return:   transfer response
+static uint32_t CoreRegReady(uint32_t ap, uint32_t csw) {
+  uint32_t  response_value;
+  uint32_t  done;
+  uint32_t  n;
+  uint8_t   data[4];
+
+  for (n = CORE_REG_RETRY; n; n--) {
+    response_value = DAP_ReadMemory(ap, csw, DHCSR, data, 1, &done);
+    if (response_value != DAP_TRANSFER_OK) {
+      return (response_value);
+    }
+    if (data[2] & (DHCSR_S_REGRDY >> 16)) {
+      return (DAP_TRANSFER_OK);
+    }
+    if (DAP_TransferAbort) break;
+  }
+  return (DAP_TRANSFER_ERROR);
+}
+
+
+// Check that the selectors of all registers in the mask fit into DCRSR REGSEL
+//   regsel:   register selector for mask bit 0
+//   mask:     register mask
+//   return:   1 when valid, 0 otherwise
+static uint32_t CoreRegSelValid(uint32_t regsel, uint32_t mask) {
+
+  for (; mask > 1; mask >>= 1) {
+    regsel++;
+  }
+  return (regsel <= DCRSR_REGSEL_Msk);
+}
+
+
+// Read core registers into one response packet
+//   response: pointer to response data
+//   return:   number of bytes in response
+static uint32_t ReadCoreRegsPacket(uint8_t *response) {
+  uint32_t  response_value;
+  uint32_t  num;
+  uint32_t  done;
+  uint8_t   sel[4];
+  uint8_t  *data;
+
+  response_value = DAP_TRANSFER_OK;
+  data = response + 4;
+  for (num = 0; ReadCoreRegs.mask && (num < READ_MEMORY_MAX(CSW_SIZE32)); num++) {
+    if (DAP_TransferAbort) {
+      response_value = 0;
+      break;
+    }
+    while ((ReadCoreRegs.mask & 1) == 0) {
+      ReadCoreRegs.mask >>= 1;
+      ReadCoreRegs.regsel++;
+    }
+    // Select register, wait for the transfer and read the value
+    sel[0] = ReadCoreRegs.regsel;
+    sel[1] = 0;
+    sel[2] = 0;
+    sel[3] = 0;
+    response_value = DAP_WriteMemory(ReadCoreRegs.ap, ReadCoreRegs.csw, DCRSR, sel, 1, &done);
+    if (response_value != DAP_TRANSFER_OK) break;
+    response_value = CoreRegReady(ReadCoreRegs.ap, ReadCoreRegs.csw);
+    if (response_value != DAP_TRANSFER_OK) break;
+    response_value = DAP_ReadMemory(ReadCoreRegs.ap, ReadCoreRegs.csw, DCRDR, data, 1, &done);
+    if (response_value != DAP_TRANSFER_OK) break;
+    data += 4;
+    ReadCoreRegs.mask >>= 1;
+    ReadCoreRegs.regsel++;
+  }
+
+  if ((response_value != DAP_TRANSFER_OK) || (ReadCoreRegs.mask == 0)) {
+    ReadCoreRegs.active = 0;
+  }
+
+  num <<= 2;
+  *(response+0) = ID_DAP_Vendor_ReadCoreRegs;
+  *(response+1) = (uint8_t)(num >> 0);
+  *(response+2) = (uint8_t)(num >> 8);
+  *(response+3) = (uint8_t) response_value;
+
+  return (4 + num);
+}
+
+
+// Process Read Core Registers command and prepare response
+// Each set bit n of the mask reads the register with selector regsel + n
+// (DCRSR REGSEL) from the halted core. Values which do not fit into the
+// response are returned in following packets. Selectors above 0x7F are
+// rejected.
+//   request:  pointer to request data (AP index, regsel, mask (32-bit))
+//   response: pointer to response data
+//   return:   number of bytes in response
+static uint32_t DAP_ReadCoreRegsCommand(uint8_t *request, uint8_t *response) {
+  uint32_t  response_value;
+
+  DAP_TransferAbort = 0;
+  ReadCoreRegs.active = 0;
+
+  ReadCoreRegs.ap     = *(request+0);
+  ReadCoreRegs.regsel = *(request+1);
+  ReadCoreRegs.mask   = (*(request+2) <<  0) |
+                        (*(request+3) <<  8) |
+                        (*(request+4) << 16) |
+                        (*(request+5) << 24);
+
+  if (!CoreRegSelValid(*(request+1), ReadCoreRegs.mask)) {
+    response_value = DAP_TRANSFER_ERROR;
+  } else {
+    response_value = DAP_MemoryCSW(ReadCoreRegs.ap, CSW_SIZE32, &ReadCoreRegs.csw);
+  }
+  if (response_value != DAP_TRANSFER_OK) {
+    *(response+0) = 0;
+    *(response+1) = 0;
+    *(response+2) = (uint8_t)response_value;
+    return (3);
+  }
+
+  ReadCoreRegs.active = 1;
+
+  return (ReadCoreRegsPacket(response - 1) - 1);
+}
+
+
+// Process Write Core Registers command and prepare response
+// Each set bit n of the mask writes the next value to the register with
+// selector regsel + n (DCRSR REGSEL) of the halted core. The response holds
+// the number of registers written and the transfer response. Selectors above
+// 0x7F are rejected.
+//   request:  pointer to request data (AP index, regsel, mask (32-bit), values)
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+static uint32_t DAP_WriteCoreRegsCommand(uint8_t *request, uint8_t *response) {
+  uint32_t  response_value;
+  uint32_t  regsel;
+  uint32_t  mask;
+  uint32_t  csw;
+  uint32_t  ap;
+  uint32_t  num;
+  uint32_t  len;
+  uint32_t  done;
+  uint32_t  n;
+  uint8_t  *data;
+  uint8_t   sel[4];
+
+  DAP_TransferAbort = 0;
+  n = 0;
+
+  ap     = *(request+0);
+  regsel = *(request+1);
+  mask   = (*(request+2) <<  0) |
+           (*(request+3) <<  8) |
+           (*(request+4) << 16) |
+           (*(request+5) << 24);
+  for (num = 0, done = mask; done; done &= done - 1) {
+    num++;
+  }
+
+  if ((num > ((DAP_PACKET_SIZE - 7) / 4)) || !CoreRegSelValid(regsel, mask)) {
+    response_value = DAP_TRANSFER_ERROR;
+    goto end;
+  }
+
+  response_value = DAP_MemoryCSW(ap, CSW_SIZE32, &csw);
+  if (response_value != DAP_TRANSFER_OK) goto end;
+
+  data = request + 6;
+  for (; n < num; n++, data += 4) {
+    if (DAP_TransferAbort) {
+      response_value = 0;
+      break;
+    }
+    while ((mask & 1) == 0) {
+      mask >>= 1;
+      regsel++;
+    }
+    // Write value, select register and wait for the transfer
+    sel[0] = (uint8_t)regsel;
+    sel[1] = 0;
+    sel[2] = (uint8_t)(DCRSR_REGWnR >> 16);
+    sel[3] = 0;
+    response_value = DAP_WriteMemory(ap, csw, DCRDR, data, 1, &done);
+    if (response_value != DAP_TRANSFER_OK) break;
+    response_value = DAP_WriteMemory(ap, csw, DCRSR, sel, 1, &done);
+    if (response_value != DAP_TRANSFER_OK) break;
+    response_value = CoreRegReady(ap, csw);
+    if (response_value != DAP_TRANSFER_OK) break;
+    mask >>= 1;
+    regsel++;
+  }
+
+end:
+  len = 6 + 4*num;
+  if (len > (DAP_PACKET_SIZE - 1)) {
+    len = DAP_PACKET_SIZE - 1;          // Invalid mask: values end with the packet
+  }
+  *(response+0) = (uint8_t)n;
+  *(response+1) = (uint8_t)response_value;
+
+  return ((len << 16) | 2);
+}
+
+
+// SWD/JTAG clock rates tried by Tune Clock command (fastest first)
+static const uint32_t TuneClockRate[] = {
+  0xFFFFFFFF, 24000000, 18000000, 12000000, 10000000, 8000000, 6000000, 5000000,
+  4000000, 3000000, 2000000, 1500000, 1000000, 500000, 200000, 100000
+};
+
+#define TUNE_CLOCK_RATES        (sizeof(TuneClockRate) / sizeof(TuneClockRate[0]))
+
+
+// Read DP IDCODE on the connected debug port
+//   idcode:   pointer to IDCODE value
+//   return:   1 when IDCODE was read successfully, 0 on error
+static uint32_t TuneClockIDCode(uint32_t *idcode) {
+
+  switch (DAP_Data.debug_port) {
+#if (DAP_SWD != 0)
+    case DAP_PORT_SWD:
+      return (SWD_Transfer(DP_IDCODE | DAP_TRANSFER_RnW, idcode) == DAP_TRANSFER_OK);
+#endif
+#if (DAP_JTAG != 0)
+    case DAP_PORT_JTAG:
+      JTAG_IR(JTAG_IDCODE);
+      *idcode = JTAG_ReadIDCode();
+      return (1);
+#endif
+  }
+
+  return (0);
+}
+
+
+// Process Tune Clock command and prepare response
+// Steps up through the clock rates reading IDCODE and selects the fastest rate
+// without errors reduced by the margin. Rates which the I/O code can not
+// generate are skipped. The response lists the rates tested (kHz, 16-bit)
+// from the slowest with the number of failed reads (saturated at 255).
+//   request:  pointer to request data (samples per rate (16-bit), margin)
+//   response: pointer to response data (status, selected clock (32-bit),
+//             number of rates tested, rates and errors)
+//   return:   number of bytes in response
+static uint32_t DAP_TuneClockCommand(uint8_t *request, uint8_t *response) {
+  uint32_t  samples;
+  uint32_t  margin;
+  uint32_t  idcode;
+  uint32_t  value;
+  uint32_t  first;
+  uint32_t  rate;
+  uint32_t  next;
+  uint32_t  errors;
+  uint32_t  tested;
+  uint32_t  n;
+  uint8_t   fast_clock;
+  uint32_t  clock_delay;
+  uint8_t  *data;
+  static const uint8_t line_reset[7] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x07 };
+
+  DAP_TransferAbort = 0;
+
+  samples = *(request+0) | (*(request+1) << 8);
+  margin  = *(request+2);
+
+  fast_clock  = DAP_Data.fast_clock;
+  clock_delay = DAP_Data.clock_delay;
+  tested      = 0;
+
+  if (samples == 0) goto error;
+#if (DAP_JTAG != 0)
+  if ((DAP_Data.debug_port == DAP_PORT_JTAG) &&
+      (DAP_Data.jtag_dev.index >= DAP_Data.jtag_dev.count)) {
+    goto error;
+  }
+#endif
+
+  // Rates up to the first one below the maximum select the fast clock as well
+  for (first = 1; first < (TUNE_CLOCK_RATES - 1); first++) {
+    if (TuneClockRate[first] < MAX_SWJ_CLOCK(DELAY_FAST_CYCLES)) break;
+  }
+
+  // Reference IDCODE at the slowest rate
+  rate = TUNE_CLOCK_RATES - 1;
+  DAP_SetClock(TuneClockRate[rate]);
+  if (!TuneClockIDCode(&idcode)) goto error;
+
+  // Step up until the first rate with errors
+  data = response + 6;
+  while ((rate != 0) && !DAP_TransferAbort) {
+    next = (rate == first) ? 0 : (rate - 1);
+    DAP_SetClock(TuneClockRate[next]);
+    errors = 0;
+    for (n = samples; n && !DAP_TransferAbort; n--) {
+      if (!TuneClockIDCode(&value) || (value != idcode)) {
+        errors++;
+      }
+    }
+    value = (next == 0) ? MAX_SWJ_CLOCK(DELAY_FAST_CYCLES) : TuneClockRate[next];
+    *data++ = (uint8_t)((value / 1000) >> 0);
+    *data++ = (uint8_t)((value / 1000) >> 8);
+    *data++ = (uint8_t)((errors > 255) ? 255 : errors);
+    tested++;
+    if (errors) break;
+    rate = next;
+  }
+  if (DAP_TransferAbort) goto error;
+
+  // Apply margin
+  if (margin && (rate == 0)) {
+    rate = first;
+    margin--;
+  }
+  rate += margin;
+  if (rate >= TUNE_CLOCK_RATES) {
+    rate = TUNE_CLOCK_RATES - 1;
+  }
+  DAP_SetClock(TuneClockRate[rate]);
+
+#if (DAP_SWD != 0)
+  if (DAP_Data.debug_port == DAP_PORT_SWD) {
+    // Recover from protocol errors: line reset and IDCODE read
+    SWJ_Sequence(51 + 2, (uint8_t *)line_reset);
+    if (!TuneClockIDCode(&value)) goto error;
+  }
+#endif
+  // Failed reads may have been taken as register writes by the target
+  DAP_CacheInvalidate();
+
+  value = (rate == 0) ? MAX_SWJ_CLOCK(DELAY_FAST_CYCLES) : TuneClockRate[rate];
+  *(response+0) = DAP_OK;
+  *(response+1) = (uint8_t)(value >>  0);
+  *(response+2) = (uint8_t)(value >>  8);
+  *(response+3) = (uint8_t)(value >> 16);
+  *(response+4) = (uint8_t)(value >> 24);
+  *(response+5) = (uint8_t)tested;
+  return (6 + 3*tested);
+
+error:
+  DAP_Data.fast_clock  = fast_clock;
+  DAP_Data.clock_delay = clock_delay;
+#if (DAP_SWD != 0)
+  SWD_TransferSelect();
+#endif
+  DAP_CacheInvalidate();
+  *(response+0) = DAP_ERROR;
+  *(response+1) = 0;
+  *(response+2) = 0;
+  *(response+3) = 0;
+  *(response+4) = 0;
+  *(response+5) = (uint8_t)tested;
+  return (6 + 3*tested);
+}
+
+
+// Store 32-bit value (little endian)
+//   data:     pointer to data
+//   value:    value to store
+//   return:   pointer to data following the value
+static uint8_t *Store32(uint8_t *data, uint32_t value) {
+  *data++ = (uint8_t)(value >>  0);
+  *data++ = (uint8_t)(value >>  8);
+  *data++ = (uint8_t)(value >> 16);
+  *data++ = (uint8_t)(value >> 24);
+  return (data);
+}
+
+
+#if (DAP_PROFILE != 0)
+
+// Bytes per profile entry: ID, count, max, wait, error, cycles[63:0]
+#define PROFILE_ENTRY_SIZE      25
+
+// Pending Profile readout
+static struct {
+  uint8_t   active;                             // Readout is pending
+  uint8_t   reset;                              // Reset profile after readout
+  uint8_t   idx;                                // Next profile entry
+} ProfileRead;
+
+
+// Write used profile entries which fit into the response
+//   response: pointer to response data (entry count followed by entries)
+//   size:     number of bytes available in response
+//   return:   number of bytes in response
+static uint32_t ProfilePacket(uint8_t *response, uint32_t size) {
+  uint8_t  *data;
+  uint32_t  num;
+  uint32_t  idx;
+
+  data = response + 1;
+  num  = 0;
+  for (idx = ProfileRead.idx; idx < DAP_PROFILE_NUM; idx++) {
+    if (DAP_Profile.cmd[idx].count == 0) continue;
+    if ((data + PROFILE_ENTRY_SIZE) > (response + size)) break;
+    *data++ = DAP_PROFILE_ID(idx);
+    data = Store32(data, DAP_Profile.cmd[idx].count);
+    data = Store32(data, DAP_Profile.cmd[idx].max);
+    data = Store32(data, DAP_Profile.cmd[idx].wait);
+    data = Store32(data, DAP_Profile.cmd[idx].error);
+    data = Store32(data, (uint32_t)(DAP_Profile.cmd[idx].cycles >>  0));
+    data = Store32(data, (uint32_t)(DAP_Profile.cmd[idx].cycles >> 32));
+    num++;
+  }
+  ProfileRead.idx = idx;
+
+  if (idx == DAP_PROFILE_NUM) {
+    ProfileRead.active = 0;
+    if (ProfileRead.reset) {
+      DAP_ProfileReset();
+    }
+  }
+
+  *response = (uint8_t)num;
+  return (data - response);
+}
+
+#endif
+
+
+// Process Profile command and prepare response
+// Returns the cycle profile of the DAP commands. Entries which do not fit into
+// the response are returned in following packets (ID, count, entries).
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response
+static uint32_t DAP_ProfileCommand(uint8_t *request, uint8_t *response) {
+#if (DAP_PROFILE != 0)
+  uint8_t  *data;
+  uint32_t  total;
+  uint32_t  idx;
+
+  total = 0;
+  for (idx = 0; idx < DAP_PROFILE_NUM; idx++) {
+    if (DAP_Profile.cmd[idx].count) total++;
+  }
+
+  ProfileRead.active = 1;
+  ProfileRead.reset  = *request & 0x01;
+  ProfileRead.idx    = 0;
+
+  data = response;
+  *data++ = DAP_OK;
+  *data++ = (uint8_t)total;
+  data = Store32(data, CPU_CLOCK);
+  data = Store32(data, (uint32_t)(DAP_Profile.idle >>  0));
+  data = Store32(data, (uint32_t)(DAP_Profile.idle >> 32));
+
+  return ((data - response) + ProfilePacket(data, DAP_PACKET_SIZE - 1 - (data - response)));
+#else
+  *response = DAP_ERROR;
+  return (1);
+#endif
+}
+
+
+// Process Transfer Statistics command and prepare response
+// Returns the WAIT retry histogram followed by the WAIT expired, FAULT,
+// parity error, protocol error and match mismatch counts.
+//   request:  pointer to request data (bit 0: reset statistics after readout)
+//   response: pointer to response data
+//   return:   number of bytes in response
+static uint32_t DAP_TransferStatCommand(uint8_t *request, uint8_t *response) {
+  uint8_t  *data;
+  uint32_t  n;
+
+  data = response;
+  *data++ = DAP_OK;
+  for (n = 0; n < DAP_STAT_WAIT_NUM; n++) {
+    data = Store32(data, DAP_TransferStat.wait[n]);
+  }
+  data = Store32(data, DAP_TransferStat.wait_expired);
+  data = Store32(data, DAP_TransferStat.fault);
+  data = Store32(data, DAP_TransferStat.parity);
+  data = Store32(data, DAP_TransferStat.protocol);
+  data = Store32(data, DAP_TransferStat.mismatch);
+
+  if (*request & 0x01) {
+    memset(&DAP_TransferStat, 0, sizeof(DAP_TransferStat));
+  }
+
+  return (data - response);
+}
+
+
+// Process Transfer Timeout command and prepare response
+// Sets the WAIT retry policy: with a time budget the retry count of the
+// Transfer Configure command is not used. A budget of 0 restores it. The
+// budget starts with each command and is shared by all of its transfers.
+// It is a vendor command because the Transfer Configure request has a fixed
+// length which hosts rely on (also inside ExecuteCommands). Connect resets it.
+//   request:  pointer to request data (time budget in us (32-bit), maximum
+//             backoff between retries in us (16-bit, 0 = no backoff))
+//   response: pointer to response data
+//   return:   number of bytes in response
+static uint32_t DAP_TransferTimeoutCommand(uint8_t *request, uint8_t *response) {
+#if (DAP_WAIT_TIMEOUT != 0)
+  uint32_t  timeout;
+  uint32_t  backoff;
+
+  timeout = (*(request+0) <<  0) |
+            (*(request+1) <<  8) |
+            (*(request+2) << 16) |
+            (*(request+3) << 24);
+  backoff = (*(request+4) <<  0) |
+            (*(request+5) <<  8);
+
+  // Limit budget to half the cycle counter range
+  if (timeout > (0x7FFFFFFF / (CPU_CLOCK/1000000))) {
+    timeout = 0x7FFFFFFF / (CPU_CLOCK/1000000);
+  }
+  DAP_Data.transfer.wait_timeout = timeout * (CPU_CLOCK/1000000);
+  DAP_Data.transfer.wait_backoff = backoff * (CPU_CLOCK/1000000);
+
+  *response = DAP_OK;
+#else
+  *response = DAP_ERROR;
+#endif
+  return (1);
+}
+
+
+// Process DAP Vendor command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t DAP_ProcessVendorCommand(uint8_t *request, uint8_t *response) {
+  uint32_t num;
+
+  // A new command ends multi-packet responses of the previous one
+  ReadMemory.active = 0;
+  ReadCoreRegs.active = 0;
+#if (DAP_PROFILE != 0)
+  ProfileRead.active = 0;
+#endif
+
+  *response++ = *request;
+
+  switch (*request++) {
+    case ID_DAP_Vendor_ReadMemory:
+      num = (9 << 16) | DAP_ReadMemoryCommand(request, response);
+      break;
+    case ID_DAP_Vendor_WriteMemory:
+      num = DAP_WriteMemoryCommand(request, response);
+      break;
+    case ID_DAP_Vendor_TuneClock:
+      num = (3 << 16) | DAP_TuneClockCommand(request, response);
+      break;
+    case ID_DAP_Vendor_Profile:
+      num = (1 << 16) | DAP_ProfileCommand(request, response);
+      break;
+    case ID_DAP_Vendor_TransferStat:
+      num = (1 << 16) | DAP_TransferStatCommand(request, response);
+      break;
+    case ID_DAP_Vendor_TransferTimeout:
+      num = (6 << 16) | DAP_TransferTimeoutCommand(request, response);
+      break;
+    case ID_DAP_Vendor_RTT:
+#if ((DAP_RTT != 0) && defined(CONF_CDC))
+      num = RTT_Control(request, response);
+#else
+      *response = DAP_ERROR;
+      num = (10 << 16) | 1;
+#endif
+      break;
+    case ID_DAP_Vendor_PC_Sample:
+#if (DAP_PC_SAMPLE != 0)
+      num = PC_SampleCommand(request, response);
+#else
+      *response = DAP_ERROR;
+      num = (1 << 16) | 1;
+#endif
+      break;
+    case ID_DAP_Vendor_Watch:
+#if (DAP_WATCH != 0)
+      num = WatchCommand(request, response);
+#else
+      *response = DAP_ERROR;
+      num = (1 << 16) | 1;
+#endif
+      break;
+    case ID_DAP_Vendor_ReadCoreRegs:
+      num = (6 << 16) | DAP_ReadCoreRegsCommand(request, response);
+      break;
+    case ID_DAP_Vendor_WriteCoreRegs:
+      num = DAP_WriteCoreRegsCommand(request, response);
+      break;
+    default:
+      *(response-1) = ID_DAP_Invalid;
+      return ((1 << 16) | 1);
+  }
+
+  return ((1 << 16) + 1 + num);
+}
+
+
+// Continue DAP Vendor command which spans several response packets
+//   response: pointer to response data
+//   return:   number of bytes in response (0 when no response is pending)
+uint32_t DAP_ContinueVendorCommand(uint8_t *response) {
+
+  DAP_TransferBudgetStart();
+
+  if (ReadMemory.active) {
+    return (ReadMemoryPacket(response));
+  }
+  if (ReadCoreRegs.active) {
+    return (ReadCoreRegsPacket(response));
+  }
+#if (DAP_PROFILE != 0)
+  if (ProfileRead.active) {
+    *response = ID_DAP_Vendor_Profile;
+    return (1 + ProfilePacket(response + 1, DAP_PACKET_SIZE - 1));
+  }
+#endif
+
+  return (0);
+}
@@ -60,18 +60,21 @@
 
 
 // Generate JTAG Sequence
+// A transfer abort request ends the sequence on the next byte boundary.
 //   info:   sequence information
 //   tdi:    pointer to TDI generated data
 //   tdo:    pointer to TDO captured data
-//   return: none
-void JTAG_Sequence (uint32_t info, uint8_t *tdi, uint8_t *tdo) {
+//   return: number of generated bits (less than sequence length when aborted)
+uint32_t JTAG_Sequence (uint32_t info, uint8_t *tdi, uint8_t *tdo) {
   uint32_t i_val;
   uint32_t o_val;
   uint32_t bit;
+  uint32_t count;
   uint32_t n, k;
 
-  n = info & JTAG_SEQUENCE_TCK;
-  if (n == 0) n = 64;
+  count = info & JTAG_SEQUENCE_TCK;
+  if (count == 0) count = 64;
+  n = count;
 
   if (info & JTAG_SEQUENCE_TMS) {
     PIN_TMS_SET();
@@ -92,7 +95,10 @@ void JTAG_Sequence (uint32_t info, uint8_t *tdi, uint8_t *tdo) {
     if (info & JTAG_SEQUENCE_TDO) {
       *tdo++ = o_val;
     }
+    if (DAP_TransferAbort) break;
   }
+
+  return (count - n);
 }
 
 
@@ -341,11 +347,17 @@ void JTAG_IR (uint32_t ir) {
 //   data:    DATA[31:0]
 //   return:  ACK[2:0]
 uint8_t  JTAG_Transfer(uint32_t request, uint32_t *data) {
+  uint8_t ack;
+
   if (DAP_Data.fast_clock) {
-    return JTAG_TransferFast(request, data);
+    ack = JTAG_TransferFast(request, data);
   } else {
-    return JTAG_TransferSlow(request, data);
+    ack = JTAG_TransferSlow(request, data);
   }
+#if (DAP_PROFILE != 0)
+  DAP_ProfileAck(ack);
+#endif
+  return (ack);
 }
 
 
@@ -0,0 +1,326 @@
+/* CMSIS-DAP Interface Firmware
+ * Copyright (c) 2009-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include "DAP_config.h"
+#include "DAP.h"
+
+#if (DAP_PC_SAMPLE != 0)
+
+#if (DAP_REG_CACHE == 0)
+#error "PC sampling requires the DP/AP register cache (DAP_REG_CACHE)"
+#endif
+#if (((DAP_PC_SAMPLE_BUCKETS & (DAP_PC_SAMPLE_BUCKETS - 1)) != 0) || (DAP_PC_SAMPLE_BUCKETS > 65536))
+#error "PC Sample Buckets must be a power of two up to 65536"
+#endif
+
+// PC sampling
+// The target PC is read from DWT_PCSR while the debugger does not use the DAP
+// link. Samples are counted in a hash table keyed by PC (histogram mode) or
+// kept in a FIFO (raw mode) until the host reads them.
+
+#define DWT_PCSR                0xE000101C      // DWT Program Counter Sample Register
+#define PCSR_HALTED             0xFFFFFFFF      // PCSR value while the core is halted
+
+#define PC_SAMPLE_BATCH         16      // Maximum samples per burst
+#define PC_SAMPLE_PROBE         8       // Hash table slots probed per PC
+#define PC_SAMPLE_RAW_SIZE      (2*DAP_PC_SAMPLE_BUCKETS)       // Raw FIFO size in samples
+
+// PC Sample commands
+#define PC_SAMPLE_STOP          0       // Stop sampling
+#define PC_SAMPLE_HISTOGRAM     1       // Start sampling into histogram
+#define PC_SAMPLE_RAW           2       // Start sampling into raw FIFO
+#define PC_SAMPLE_READ          3       // Read top buckets or raw samples
+#define PC_SAMPLE_DRAIN         4       // Read top buckets and clear them
+
+// Bytes in read response before the data (status, mode, ACK, samples, halted, dropped, count)
+#define PC_SAMPLE_HEADER        16
+
+static struct {
+  uint8_t   mode;                               // Sampling mode (0 = not started)
+  uint8_t   run;                                // Sampling active
+  uint8_t   ack;                                // ACK of the transfer which stopped sampling (OK = none)
+  uint8_t   ap;                                 // MEM-AP index
+  uint32_t  csw;                                // MEM-AP CSW (32-bit, no increment)
+  uint32_t  interval;                           // Sample interval in cycles (0 = continuous)
+  uint32_t  last;                               // Cycle Counter at last sample
+  uint32_t  samples;                            // Samples taken
+  uint32_t  halted;                             // Samples while the core was halted
+  uint32_t  dropped;                            // Samples not stored (table or FIFO full)
+  uint32_t  in;                                 // Raw FIFO write counter
+  uint32_t  out;                                // Raw FIFO read counter
+} PC_Sample;
+
+// Histogram buckets or raw FIFO (count 0 marks a bucket cleared by drain)
+static union {
+  struct {
+    uint32_t  pc;                               // Program Counter (0 = unused)
+    uint32_t  count;                            // Number of samples
+  } bucket[DAP_PC_SAMPLE_BUCKETS];
+  uint32_t    raw[PC_SAMPLE_RAW_SIZE];
+} PC_Table;
+
+
+// Put 32-bit value into data as little endian
+static uint8_t *Store32(uint8_t *data, uint32_t value) {
+  *data++ = (uint8_t)(value >>  0);
+  *data++ = (uint8_t)(value >>  8);
+  *data++ = (uint8_t)(value >> 16);
+  *data++ = (uint8_t)(value >> 24);
+  return (data);
+}
+
+
+// Count sample in histogram
+// Open addressing with linear probing; PCs are halfword aligned. A new PC
+// takes the first bucket cleared by drain on its probe sequence.
+//   pc:      sampled Program Counter
+static void PC_SampleCount(uint32_t pc) {
+  uint32_t free;
+  uint32_t idx;
+  uint32_t n;
+
+  free = DAP_PC_SAMPLE_BUCKETS;
+  idx  = ((pc >> 1) * 0x9E3779B1) >> 16;
+  for (n = 0; n < PC_SAMPLE_PROBE; n++, idx++) {
+    idx &= DAP_PC_SAMPLE_BUCKETS - 1;
+    if (PC_Table.bucket[idx].pc == pc) {
+      PC_Table.bucket[idx].count++;
+      return;
+    }
+    if (PC_Table.bucket[idx].pc == 0) {
+      if (free == DAP_PC_SAMPLE_BUCKETS) free = idx;
+      break;
+    }
+    if ((PC_Table.bucket[idx].count == 0) && (free == DAP_PC_SAMPLE_BUCKETS)) {
+      free = idx;
+    }
+  }
+  if (free == DAP_PC_SAMPLE_BUCKETS) {
+    PC_Sample.dropped++;
+    return;
+  }
+  PC_Table.bucket[free].pc    = pc;
+  PC_Table.bucket[free].count = 1;
+}
+
+
+// Store sample
+//   pc:      sampled Program Counter
+static void PC_SampleStore(uint32_t pc) {
+
+  PC_Sample.samples++;
+  if (pc == PCSR_HALTED) {
+    PC_Sample.halted++;
+    return;
+  }
+
+  if (PC_Sample.mode == PC_SAMPLE_HISTOGRAM) {
+    PC_SampleCount(pc);
+  } else if ((PC_Sample.in - PC_Sample.out) < PC_SAMPLE_RAW_SIZE) {
+    PC_Table.raw[PC_Sample.in++ & (PC_SAMPLE_RAW_SIZE - 1)] = pc;
+  } else {
+    PC_Sample.dropped++;
+  }
+}
+
+
+// Take PC samples
+// Must only be called while the debugger does not use the DAP link. DP SELECT
+// and MEM-AP registers are restored after the accesses. A failed transfer
+// stops sampling; the debugger reads the ACK with the Read command.
+//   budget:  maximum number of samples
+//   return:  number of samples taken
+uint32_t pc_sample_process(uint32_t budget) {
+  DAP_HostState_t host;
+  uint8_t  data[4*PC_SAMPLE_BATCH];
+  uint32_t num;
+  uint32_t done;
+  uint32_t n;
+  uint8_t  ack;
+
+  if (!PC_Sample.run) {
+    return (0);
+  }
+
+  num = PC_SAMPLE_BATCH;
+  if (PC_Sample.interval) {
+    if ((DWT->CYCCNT - PC_Sample.last) < PC_Sample.interval) {
+      return (0);
+    }
+    num = 1;
+  }
+  if (num > budget) {
+    num = budget;
+  }
+  if ((num == 0) || !DAP_SaveHostState(PC_Sample.ap, &host)) {
+    return (0);
+  }
+
+  // Burst of PCSR reads (TAR is not incremented)
+  PC_Sample.last = DWT->CYCCNT;
+  ack = DAP_ReadMemory(PC_Sample.ap, PC_Sample.csw, DWT_PCSR, data, num, &done);
+  for (n = 0; n < done; n++) {
+    PC_SampleStore(data[4*n] | (data[4*n+1] << 8) | (data[4*n+2] << 16) | (data[4*n+3] << 24));
+  }
+
+  DAP_RestoreHostState(PC_Sample.ap, &host);
+  if (ack != DAP_TRANSFER_OK) {
+    PC_Sample.ack = ack;
+    PC_Sample.run = 0;
+  }
+  return (done);
+}
+
+
+// Write histogram buckets with the highest counts which fit into the response
+//   data:    pointer to response data
+//   max:     maximum number of buckets
+//   drain:   clear returned buckets
+//   return:  number of buckets
+static uint32_t PC_SampleTop(uint8_t *data, uint32_t max, uint32_t drain) {
+  uint32_t limit;
+  uint32_t best;
+  uint32_t idx;
+  uint32_t num;
+  uint32_t n;
+
+  // Select buckets in order of count (then index), each after the previous one
+  limit = 0xFFFFFFFF;
+  idx   = DAP_PC_SAMPLE_BUCKETS;
+  for (num = 0; num < max; num++) {
+    best = DAP_PC_SAMPLE_BUCKETS;
+    for (n = 0; n < DAP_PC_SAMPLE_BUCKETS; n++) {
+      if ((PC_Table.bucket[n].count == 0) || (PC_Table.bucket[n].count > limit)) continue;
+      if ((PC_Table.bucket[n].count == limit) && (n <= idx)) continue;
+      if ((best == DAP_PC_SAMPLE_BUCKETS) || (PC_Table.bucket[n].count > PC_Table.bucket[best].count)) {
+        best = n;
+      }
+    }
+    if (best == DAP_PC_SAMPLE_BUCKETS) break;
+    idx   = best;
+    limit = PC_Table.bucket[idx].count;
+    data  = Store32(data, PC_Table.bucket[idx].pc);
+    data  = Store32(data, PC_Table.bucket[idx].count);
+  }
+
+  if (drain && num) {
+    // Cleared buckets keep their PC so that probe sequences stay intact,
+    // PC_SampleCount reuses them for new PCs
+    for (n = 0; n < DAP_PC_SAMPLE_BUCKETS; n++) {
+      if ((PC_Table.bucket[n].count > limit) ||
+          ((PC_Table.bucket[n].count == limit) && (n <= idx))) {
+        PC_Table.bucket[n].count = 0;
+      }
+    }
+  }
+
+  return (num);
+}
+
+
+// Process PC Sample command and prepare response
+// Start sets the MEM-AP and the sample interval and clears previous samples.
+// Read returns the sample counters followed by the buckets with the highest
+// counts (PC, count) or the oldest raw samples (PC) which fit into the response.
+// Samples stay readable after Stop. When a transfer failed, sampling is stopped
+// and Read returns DAP_ERROR with the ACK of that transfer.
+//   request:  pointer to request data (command, for start: AP index and
+//             sample interval in us (32-bit, 0 = continuous))
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t PC_SampleCommand(uint8_t *request, uint8_t *response) {
+  DAP_HostState_t host;
+  uint32_t saved;
+  uint32_t interval;
+  uint32_t num;
+  uint32_t n;
+  uint8_t  status;
+  uint8_t *data;
+
+  status = DAP_OK;
+  switch (*request) {
+    case PC_SAMPLE_STOP:
+      PC_Sample.run = 0;
+      *response = status;
+      return ((1 << 16) | 1);
+
+    case PC_SAMPLE_HISTOGRAM:
+    case PC_SAMPLE_RAW:
+      interval = (*(request+2) <<  0) |
+                 (*(request+3) <<  8) |
+                 (*(request+4) << 16) |
+                 (*(request+5) << 24);
+      if (interval > (0x7FFFFFFF / (CPU_CLOCK/1000000))) {
+        interval = 0x7FFFFFFF / (CPU_CLOCK/1000000);
+      }
+      memset(&PC_Sample, 0, sizeof(PC_Sample));
+      memset(&PC_Table,  0, sizeof(PC_Table));
+      PC_Sample.ap       = *(request+1);
+      PC_Sample.interval = interval * (CPU_CLOCK/1000000);
+      PC_Sample.last     = DWT->CYCCNT;
+      // Keep the host view of the registers when it is known
+      saved = DAP_SaveHostState(PC_Sample.ap, &host);
+      if (DAP_MemoryCSW(PC_Sample.ap, CSW_SIZE32, &PC_Sample.csw) == DAP_TRANSFER_OK) {
+        PC_Sample.csw  = (PC_Sample.csw & ~CSW_ADDRINC_Msk) | CSW_ADDRINC_OFF;
+        PC_Sample.mode = *request;
+        PC_Sample.ack  = DAP_TRANSFER_OK;
+        PC_Sample.run  = 1;
+      } else {
+        status = DAP_ERROR;
+      }
+      if (saved) {
+        DAP_RestoreHostState(PC_Sample.ap, &host);
+      }
+      *response = status;
+      return ((6 << 16) | 1);
+
+    case PC_SAMPLE_READ:
+    case PC_SAMPLE_DRAIN:
+      if ((PC_Sample.mode != PC_SAMPLE_STOP) && (PC_Sample.ack != DAP_TRANSFER_OK)) {
+        status = DAP_ERROR;
+      }
+      data = response;
+      *data++ = status;
+      *data++ = PC_Sample.run ? PC_Sample.mode : PC_SAMPLE_STOP;
+      *data++ = PC_Sample.ack;
+      data = Store32(data, PC_Sample.samples);
+      data = Store32(data, PC_Sample.halted);
+      data = Store32(data, PC_Sample.dropped);
+      if (PC_Sample.mode == PC_SAMPLE_RAW) {
+        num = PC_Sample.in - PC_Sample.out;
+        if (num > ((DAP_PACKET_SIZE - 1 - PC_SAMPLE_HEADER) / 4)) {
+          num = (DAP_PACKET_SIZE - 1 - PC_SAMPLE_HEADER) / 4;
+        }
+        for (n = 0; n < num; n++) {
+          Store32(data + 1 + 4*n, PC_Table.raw[PC_Sample.out++ & (PC_SAMPLE_RAW_SIZE - 1)]);
+        }
+        n = 4 * num;
+      } else {
+        num = PC_SampleTop(data + 1, (DAP_PACKET_SIZE - 1 - PC_SAMPLE_HEADER) / 8,
+                           *request == PC_SAMPLE_DRAIN);
+        n = 8 * num;
+      }
+      *data = (uint8_t)num;
+      return ((1 << 16) | (PC_SAMPLE_HEADER + n));
+  }
+
+  *response = DAP_ERROR;
+  return ((1 << 16) | 1);
+}
+
+#endif  /* (DAP_PC_SAMPLE != 0) */
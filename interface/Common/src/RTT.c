@@ -0,0 +1,426 @@
+/* CMSIS-DAP Interface Firmware
+ * Copyright (c) 2009-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <RTL.h>
+#include <rl_usb.h>
+#include "DAP_config.h"
+#include "DAP.h"
+
+#if ((DAP_RTT != 0) && defined(CONF_CDC))
+
+#if (DAP_REG_CACHE == 0)
+#error "RTT console requires the DP/AP register cache (DAP_REG_CACHE)"
+#endif
+
+// RTT console
+// The target keeps a control block with ring buffers in RAM. The probe finds
+// the block by its ID and moves channel 0 between the rings and the CDC serial
+// port while the debugger does not use the DAP link.
+
+#define RTT_SEARCH_BLOCK        64      // Bytes read per search step
+#define RTT_CHUNK               64      // Bytes moved per direction and poll
+
+// RTT control block layout
+#define RTT_CB_ID               0x00    // Control block ID (16 bytes)
+#define RTT_CB_MAX_UP           0x10    // Number of up buffers (target to host)
+#define RTT_CB_MAX_DOWN         0x14    // Number of down buffers (host to target)
+#define RTT_CB_BUFFERS          0x18    // Up buffer descriptors, then down buffer descriptors
+#define RTT_CB_ID_SIZE          16
+#define RTT_CB_MAX_BUFFERS      32
+
+// RTT buffer descriptor layout
+#define RTT_BUF_NAME            0x00    // Buffer name
+#define RTT_BUF_DATA            0x04    // Buffer data
+#define RTT_BUF_SIZE            0x08    // Buffer size
+#define RTT_BUF_WROFF           0x0C    // Write offset
+#define RTT_BUF_RDOFF           0x10    // Read offset
+#define RTT_BUF_DESC_SIZE       0x18
+
+// RTT state
+#define RTT_OFF                 0       // Not polling
+#define RTT_SEARCH              1       // Searching control block
+#define RTT_ATTACHED            2       // Control block found
+#define RTT_ERROR               3       // Stopped on transfer error
+
+static const uint8_t RTT_ID[RTT_CB_ID_SIZE] = "SEGGER RTT";
+
+// RTT buffer
+typedef struct {
+  uint32_t  desc;                               // Descriptor address
+  uint32_t  data;                               // Data address
+  uint32_t  size;                               // Size in bytes
+} RTT_Buffer_t;
+
+static struct {
+  uint8_t       state;                          // RTT state
+  uint8_t       ap;                             // MEM-AP index
+  uint32_t      csw;                            // MEM-AP CSW (32-bit access)
+  uint32_t      start;                          // Search range start
+  uint32_t      end;                            // Search range end
+  uint32_t      addr;                           // Next search address
+  uint32_t      cb;                             // Control block address
+  RTT_Buffer_t  up;                             // Channel 0 up buffer
+  RTT_Buffer_t  down;                           // Channel 0 down buffer (size 0 = none)
+  uint8_t       ack;                            // ACK of the failed transfer (OK = none)
+  uint32_t      pending;                        // Bytes in input not written yet
+  uint8_t       input[RTT_CHUNK];               // Data read from the CDC serial port
+} RTT;
+
+
+// Get 32-bit value from little endian data
+static uint32_t Load32(uint8_t *data) {
+  return ((data[0] <<  0) |
+          (data[1] <<  8) |
+          (data[2] << 16) |
+          (data[3] << 24));
+}
+
+
+// Read target words
+//   addr:    word aligned address
+//   data:    pointer to data buffer (4 bytes per word)
+//   count:   number of words
+//   return:  1 when all words were read, 0 on error
+static uint32_t RTT_Read(uint32_t addr, uint8_t *data, uint32_t count) {
+  uint32_t done;
+  uint8_t  ack;
+
+  ack = DAP_ReadMemory(RTT.ap, RTT.csw, addr, data, count, &done);
+  if (ack != DAP_TRANSFER_OK) {
+    RTT.ack = ack;
+    return (0);
+  }
+  return (done == count);
+}
+
+
+// Write target word
+//   addr:    word aligned address
+//   value:   data value
+//   return:  1 when the word was written, 0 on error
+static uint32_t RTT_Write32(uint32_t addr, uint32_t value) {
+  uint8_t  data[4];
+  uint32_t done;
+  uint8_t  ack;
+
+  data[0] = (uint8_t)(value >>  0);
+  data[1] = (uint8_t)(value >>  8);
+  data[2] = (uint8_t)(value >> 16);
+  data[3] = (uint8_t)(value >> 24);
+  ack = DAP_WriteMemory(RTT.ap, RTT.csw, addr, data, 1, &done);
+  if (ack != DAP_TRANSFER_OK) {
+    RTT.ack = ack;
+    return (0);
+  }
+  return (1);
+}
+
+
+// Read buffer descriptor
+//   desc:    descriptor address
+//   buf:     pointer to buffer
+//   return:  1 when the descriptor is valid, 0 otherwise
+static uint32_t RTT_ReadBuffer(uint32_t desc, RTT_Buffer_t *buf) {
+  uint8_t data[RTT_BUF_DESC_SIZE];
+
+  if (!RTT_Read(desc, data, RTT_BUF_DESC_SIZE / 4)) {
+    return (0);
+  }
+  buf->desc = desc;
+  buf->data = Load32(data + RTT_BUF_DATA);
+  buf->size = Load32(data + RTT_BUF_SIZE);
+  return (buf->size != 0);
+}
+
+
+// Check control block at the given address and read channel 0 descriptors
+//   cb:      control block address
+//   return:  1 when the control block is valid, 0 otherwise
+static uint32_t RTT_Attach(uint32_t cb) {
+  uint8_t  data[8];
+  uint32_t up;
+  uint32_t down;
+
+  if (!RTT_Read(cb + RTT_CB_MAX_UP, data, 2)) {
+    return (0);
+  }
+  up   = Load32(data + 0);
+  down = Load32(data + 4);
+  if ((up == 0) || (up > RTT_CB_MAX_BUFFERS) || (down > RTT_CB_MAX_BUFFERS)) {
+    return (0);
+  }
+
+  if (!RTT_ReadBuffer(cb + RTT_CB_BUFFERS, &RTT.up)) {
+    return (0);
+  }
+  RTT.down.size = 0;
+  if (down) {
+    RTT_ReadBuffer(cb + RTT_CB_BUFFERS + up * RTT_BUF_DESC_SIZE, &RTT.down);
+  }
+
+  RTT.cb    = cb;
+  RTT.state = RTT_ATTACHED;
+  return (1);
+}
+
+
+// Search next block of the search range for the control block ID
+// The ID is word aligned; blocks overlap so that an ID across two blocks is found.
+//   return:  1 when the search continues, 0 when the control block was found
+static uint32_t RTT_Search(void) {
+  uint8_t  data[RTT_SEARCH_BLOCK];
+  uint32_t addr;
+  uint32_t len;
+  uint32_t n;
+
+  addr = RTT.addr;
+  len  = RTT.end - addr;
+  if (len > RTT_SEARCH_BLOCK) {
+    len = RTT_SEARCH_BLOCK;
+  }
+  if (len < RTT_CB_ID_SIZE) {
+    // End of range: the target may create the control block later
+    RTT.addr = RTT.start;
+    return (1);
+  }
+  RTT.addr = addr + len - RTT_CB_ID_SIZE + 4;
+
+  if (!RTT_Read(addr, data, len / 4)) {
+    return (1);
+  }
+  for (n = 0; (n + RTT_CB_ID_SIZE) <= len; n += 4) {
+    if ((memcmp(data + n, RTT_ID, RTT_CB_ID_SIZE) == 0) && RTT_Attach(addr + n)) {
+      return (0);
+    }
+  }
+  return (1);
+}
+
+
+// Move data from the up buffer to the CDC serial port
+//   budget:  maximum number of bytes
+//   return:  number of bytes moved
+static uint32_t RTT_Up(uint32_t budget) {
+  uint8_t  data[RTT_CHUNK + 8];
+  uint32_t wr, rd;
+  uint32_t addr;
+  uint32_t n;
+
+  n = USBD_CDC_ACM_DataFree();
+  if (n > budget)    n = budget;
+  if (n > RTT_CHUNK) n = RTT_CHUNK;
+  if (n == 0) {
+    return (0);
+  }
+
+  if (!RTT_Read(RTT.up.desc + RTT_BUF_WROFF, data, 2)) {
+    return (0);
+  }
+  wr = Load32(data + 0);
+  rd = Load32(data + 4);
+  if ((wr >= RTT.up.size) || (rd >= RTT.up.size) || (wr == rd)) {
+    return (0);
+  }
+
+  // Contiguous data up to the write offset or the end of the buffer
+  if (wr < rd) wr = RTT.up.size;
+  if (n > (wr - rd)) n = wr - rd;
+
+  // Read whole words covering the data
+  addr = RTT.up.data + rd;
+  if (!RTT_Read(addr & ~3, data, ((addr & 3) + n + 3) / 4)) {
+    return (0);
+  }
+
+  rd += n;
+  if (rd == RTT.up.size) rd = 0;
+  if (!RTT_Write32(RTT.up.desc + RTT_BUF_RDOFF, rd)) {
+    return (0);
+  }
+
+  USBD_CDC_ACM_DataSend(data + (addr & 3), n);
+  return (n);
+}
+
+
+// Move data from the CDC serial port to the down buffer
+// Data read from the CDC serial port is kept until it was written to the target.
+//   budget:  maximum number of bytes
+//   return:  number of bytes moved
+static uint32_t RTT_Down(uint32_t budget) {
+  uint8_t  data[8];
+  uint32_t wr, rd;
+  uint32_t csw;
+  uint32_t done;
+  uint32_t n;
+  uint8_t  ack;
+
+  if (RTT.down.size == 0) {
+    return (0);
+  }
+  if (RTT.pending == 0) {
+    n = USBD_CDC_ACM_DataAvailable();
+    if (n > RTT_CHUNK) n = RTT_CHUNK;
+    if (n != 0) {
+      RTT.pending = USBD_CDC_ACM_DataRead(RTT.input, n);
+    }
+  }
+  n = RTT.pending;
+  if (n > budget) n = budget;
+  if (n == 0) {
+    return (0);
+  }
+
+  if (!RTT_Read(RTT.down.desc + RTT_BUF_WROFF, data, 2)) {
+    return (0);
+  }
+  wr = Load32(data + 0);
+  rd = Load32(data + 4);
+  if ((wr >= RTT.down.size) || (rd >= RTT.down.size)) {
+    return (0);
+  }
+
+  // Contiguous free space up to the read offset or the end of the buffer
+  // (one byte stays free to tell a full buffer from an empty one)
+  if (rd > wr) {
+    if (n > (rd - wr - 1)) n = rd - wr - 1;
+  } else {
+    if (n > (RTT.down.size - wr - (rd == 0))) n = RTT.down.size - wr - (rd == 0);
+  }
+  if (n == 0) {
+    return (0);
+  }
+
+  csw = (RTT.csw & ~CSW_SIZE_Msk) | CSW_SIZE8;
+  ack = DAP_WriteMemory(RTT.ap, csw, RTT.down.data + wr, RTT.input, n, &done);
+  if (ack != DAP_TRANSFER_OK) {
+    RTT.ack = ack;
+    return (0);
+  }
+
+  wr += n;
+  if (wr == RTT.down.size) wr = 0;
+  if (!RTT_Write32(RTT.down.desc + RTT_BUF_WROFF, wr)) {
+    return (0);
+  }
+
+  RTT.pending -= n;
+  memmove(RTT.input, RTT.input + n, RTT.pending);
+  return (n);
+}
+
+
+// Check if the CDC serial port is used by the RTT console
+//   return:  1 when active, 0 otherwise
+uint32_t rtt_active(void) {
+  return ((RTT.state == RTT_SEARCH) || (RTT.state == RTT_ATTACHED));
+}
+
+
+// Poll RTT control block
+// Must only be called while the debugger does not use the DAP link. DP SELECT
+// and MEM-AP registers are restored after the accesses. A failed transfer
+// stops the console; the debugger reads the ACK with the RTT command.
+//   budget:  maximum number of bytes per direction
+//   return:  number of bytes moved (or 1 while searching)
+uint32_t rtt_process(uint32_t budget) {
+  DAP_HostState_t host;
+  uint32_t num;
+
+  if (!rtt_active()) {
+    return (0);
+  }
+  if (!DAP_SaveHostState(RTT.ap, &host)) {
+    return (0);
+  }
+
+  if (RTT.state == RTT_SEARCH) {
+    num = RTT_Search();
+  } else {
+    num  = RTT_Up(budget);
+    num += RTT_Down(budget);
+  }
+
+  DAP_RestoreHostState(RTT.ap, &host);
+  if (RTT.ack != DAP_TRANSFER_OK) {
+    RTT.state = RTT_ERROR;
+  }
+  return (num);
+}
+
+
+// Process RTT Control command and prepare response
+// Start searches the control block in the given range and bridges channel 0
+// to the CDC serial port once found. The command also reports the state and
+// the ACK of the transfer which stopped the console (state 3).
+//   request:  pointer to request data (control: bit0 = start/stop,
+//             bit1 = keep state, AP index, search start and size (32-bit))
+//   response: pointer to response data (status, state, control block address,
+//             ACK)
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t RTT_Control(uint8_t *request, uint8_t *response) {
+  DAP_HostState_t host;
+  uint32_t control;
+  uint32_t start;
+  uint32_t size;
+  uint32_t status;
+  uint32_t saved;
+
+  control = *(request+0);
+  start   = Load32(request + 2) & ~3;
+  size    = Load32(request + 6) & ~3;
+
+  status = DAP_OK;
+  if ((control & 2) == 0) {
+    RTT.state = RTT_OFF;
+    if (control & 1) {
+      if (size < RTT_CB_ID_SIZE) {
+        status = DAP_ERROR;
+      } else {
+        RTT.ap    = *(request+1);
+        RTT.start = start;
+        RTT.end   = start + size;
+        RTT.addr  = start;
+        RTT.cb    = 0;
+        RTT.ack   = DAP_TRANSFER_OK;
+        RTT.pending = 0;
+        // Keep the host view of the registers when it is known
+        saved = DAP_SaveHostState(RTT.ap, &host);
+        if (DAP_MemoryCSW(RTT.ap, CSW_SIZE32, &RTT.csw) != DAP_TRANSFER_OK) {
+          status = DAP_ERROR;
+        } else {
+          RTT.state = RTT_SEARCH;
+        }
+        if (saved) {
+          DAP_RestoreHostState(RTT.ap, &host);
+        }
+      }
+    }
+  }
+
+  *(response+0) = (uint8_t)status;
+  *(response+1) = RTT.state;
+  *(response+2) = (uint8_t)(RTT.cb >>  0);
+  *(response+3) = (uint8_t)(RTT.cb >>  8);
+  *(response+4) = (uint8_t)(RTT.cb >> 16);
+  *(response+5) = (uint8_t)(RTT.cb >> 24);
+  *(response+6) = RTT.ack;
+  return ((10 << 16) | 7);
+}
+
+#endif  /* ((DAP_RTT != 0) && defined(CONF_CDC)) */
@@ -0,0 +1,316 @@
+/* CMSIS-DAP Interface Firmware
+ * Copyright (c) 2009-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <RTL.h>
+#include <rl_usb.h>
+#include "DAP_config.h"
+#include "DAP.h"
+
+#if (SWO_UART != 0)
+
+#include "uart.h"
+#include "ring.h"
+
+#if (!RING_SIZE_OK(SWO_BUFFER_SIZE))
+#error "SWO Buffer Size must be a power of two"
+#endif
+
+#define TRACE_IDX(cnt)          RING_IDX(cnt, SWO_BUFFER_SIZE)
+
+// SWO Transport
+#define TRANSPORT_NONE          0       // No transport selected
+#define TRANSPORT_DATA          1       // Trace data read with DAP_SWO_Data
+#define TRANSPORT_STREAM        2       // Trace data streamed on the bulk endpoint
+
+#if (SWO_STREAM != 0)
+#define TRANSPORT_MAX           TRANSPORT_STREAM
+#define TraceStreamBusy()       (TraceStreamLen != 0)
+#else
+#define TRANSPORT_MAX           TRANSPORT_DATA
+#define TraceStreamBusy()       0
+#endif
+
+// Trace capture
+// The UART interrupt fills the trace buffer and the consumer (DAP_SWO_Data in
+// the main loop or the bulk endpoint in the USB interrupt) drains it. Data
+// which does not fit into the buffer is dropped and reported as overrun.
+static          uint8_t  TraceBuf[SWO_BUFFER_SIZE];     // Trace Buffer
+static          Ring_t   TraceRing;                     // Trace Buffer Ring
+static          uint8_t  TraceTransport;                // Selected Transport
+static          uint8_t  TraceMode;                     // Capture Mode
+static volatile uint8_t  TraceActive;                   // Capture is active
+static volatile uint8_t  TraceOverrun;                  // Buffer overrun since start
+#if (SWO_STREAM != 0)
+static volatile uint32_t TraceStreamLen;                // Bytes in flight on the endpoint
+#endif
+
+
+// UART receive handler (UART interrupt)
+//   data:    received data
+//   size:    number of bytes
+static void SWO_Receive(uint8_t *data, uint32_t size) {
+  uint32_t free;
+  uint32_t in;
+  uint32_t n;
+
+  if (!TraceActive) {
+    return;
+  }
+
+  free = ring_free(&TraceRing, SWO_BUFFER_SIZE);
+  if (size > free) {
+    size = free;
+    TraceOverrun = 1;
+  }
+  in = TraceRing.in;
+  for (n = 0; n < size; n++) {
+    TraceBuf[TRACE_IDX(in + n)] = *data++;
+  }
+  ring_put(&TraceRing, size);
+}
+
+
+// Check if the UART is used by SWO capture
+//   return:  1 when used (CDC serial port settings are rejected), 0 otherwise
+uint32_t swo_active(void) {
+  return (TraceMode == DAP_SWO_UART);
+}
+
+
+// Get SWO status byte
+static uint8_t SWO_GetStatus(void) {
+  uint8_t status;
+
+  status = 0;
+  if (TraceActive) {
+    status |= DAP_SWO_CAPTURE_ACTIVE;
+  }
+  if (TraceOverrun) {
+    status |= DAP_SWO_BUFFER_OVERRUN;
+  }
+  return (status);
+}
+
+
+// Process SWO Transport command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t SWO_Transport(uint8_t *request, uint8_t *response) {
+  uint8_t transport;
+
+  transport = *request;
+  if (TraceActive || TraceStreamBusy() || (transport > TRANSPORT_MAX)) {
+    *response = DAP_ERROR;
+    return ((1 << 16) | 1);
+  }
+
+  TraceTransport = transport;
+  *response = DAP_OK;
+  return ((1 << 16) | 1);
+}
+
+
+// Process SWO Mode command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t SWO_Mode(uint8_t *request, uint8_t *response) {
+  uint8_t mode;
+
+  mode = *request;
+  if (TraceActive || (mode > DAP_SWO_UART)) {
+    *response = DAP_ERROR;
+    return ((1 << 16) | 1);
+  }
+
+  if (mode == DAP_SWO_UART) {
+    // Capture takes over the UART from the CDC serial port
+    uart_initialize();
+    uart_set_receive_handler(SWO_Receive);
+  } else if (TraceMode == DAP_SWO_UART) {
+    uart_set_receive_handler(NULL);
+  }
+  TraceMode = mode;
+
+  *response = DAP_OK;
+  return ((1 << 16) | 1);
+}
+
+
+// Process SWO Baudrate command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t SWO_Baudrate(uint8_t *request, uint8_t *response) {
+  UART_Configuration config;
+  uint32_t baudrate;
+
+  baudrate = (*(request+0) <<  0) |
+             (*(request+1) <<  8) |
+             (*(request+2) << 16) |
+             (*(request+3) << 24);
+
+  if (TraceActive || (TraceMode != DAP_SWO_UART) || (baudrate == 0)) {
+    baudrate = 0;
+  } else {
+    if (baudrate > SWO_UART_MAX_BAUDRATE) {
+      baudrate = SWO_UART_MAX_BAUDRATE;
+    }
+    config.Baudrate    = baudrate;
+    config.DataBits    = UART_DATA_BITS_8;
+    config.Parity      = UART_PARITY_NONE;
+    config.StopBits    = UART_STOP_BITS_1;
+    config.FlowControl = UART_FLOW_CONTROL_NONE;
+    uart_set_configuration(&config);
+    uart_get_configuration(&config);
+    baudrate = config.Baudrate;
+  }
+
+  *(response+0) = (uint8_t)(baudrate >>  0);
+  *(response+1) = (uint8_t)(baudrate >>  8);
+  *(response+2) = (uint8_t)(baudrate >> 16);
+  *(response+3) = (uint8_t)(baudrate >> 24);
+  return ((4 << 16) | 4);
+}
+
+
+// Process SWO Control command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t SWO_Control(uint8_t *request, uint8_t *response) {
+
+  if (*request & 1) {
+    if ((TraceMode != DAP_SWO_UART) || (TraceTransport == TRANSPORT_NONE)) {
+      *response = DAP_ERROR;
+      return ((1 << 16) | 1);
+    }
+    // Drop data of the previous capture; a packet in flight on the stream
+    // endpoint is still released by the USB interrupt
+    __disable_irq();
+#if (SWO_STREAM != 0)
+    TraceRing.in = TraceRing.out + TraceStreamLen;
+#else
+    ring_init(&TraceRing);
+#endif
+    TraceOverrun = 0;
+    TraceActive  = 1;
+    __enable_irq();
+  } else {
+    TraceActive  = 0;
+  }
+
+  *response = DAP_OK;
+  return ((1 << 16) | 1);
+}
+
+
+// Process SWO Status command and prepare response
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t SWO_Status(uint8_t *response) {
+  uint32_t count;
+
+  count = ring_count(&TraceRing);
+
+  *(response+0) = SWO_GetStatus();
+  *(response+1) = (uint8_t)(count >>  0);
+  *(response+2) = (uint8_t)(count >>  8);
+  *(response+3) = (uint8_t)(count >> 16);
+  *(response+4) = (uint8_t)(count >> 24);
+  return ((0 << 16) | 5);
+}
+
+
+// Process SWO Data command and prepare response
+//   request:  pointer to request data
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t SWO_Data(uint8_t *request, uint8_t *response) {
+  uint32_t count;
+  uint32_t max;
+  uint32_t out;
+  uint32_t n;
+
+  max = *(request+0) | (*(request+1) << 8);
+  if (max > (DAP_PACKET_SIZE - 4)) {
+    max = DAP_PACKET_SIZE - 4;
+  }
+
+  count = 0;
+  if (TraceTransport == TRANSPORT_DATA) {
+    count = ring_count(&TraceRing);
+    if (count > max) {
+      count = max;
+    }
+    out = TraceRing.out;
+    for (n = 0; n < count; n++) {
+      *(response + 3 + n) = TraceBuf[TRACE_IDX(out + n)];
+    }
+    ring_get(&TraceRing, count);
+  }
+
+  *(response+0) = SWO_GetStatus();
+  *(response+1) = (uint8_t)(count >> 0);
+  *(response+2) = (uint8_t)(count >> 8);
+  return ((2 << 16) | (3 + count));
+}
+
+
+#if (SWO_STREAM != 0)
+// USB Bulk Callback: when the trace endpoint needs data (USB interrupt)
+//   Data is sent in place from the trace buffer and released on the next call.
+//   buf:      pointer to data pointer
+//   max:      maximum number of bytes (endpoint packet size)
+//   return:   number of bytes to send
+int usbd_bulk_swo_get_inbuf(U8 **buf, int max) {
+  uint32_t count;
+  uint32_t out;
+
+  // Release sent data
+  if (TraceStreamLen) {
+    ring_get(&TraceRing, TraceStreamLen);
+    TraceStreamLen = 0;
+  }
+
+  if (TraceTransport != TRANSPORT_STREAM) {
+    return (0);
+  }
+
+  // Send next contiguous block
+  count = ring_count(&TraceRing);
+  out   = TRACE_IDX(TraceRing.out);
+  if (count > (SWO_BUFFER_SIZE - out)) {
+    count = SWO_BUFFER_SIZE - out;
+  }
+  if (count > (uint32_t)max) {
+    count = max;
+  }
+
+  *buf = &TraceBuf[out];
+  TraceStreamLen = count;
+  return (count);
+}
+#endif
+
+#endif  /* (SWO_UART != 0) */
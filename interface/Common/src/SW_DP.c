@@ -47,18 +47,21 @@
 
 
 // Generate SWJ Sequence
+// A transfer abort request ends the sequence on the next byte boundary.
 //   count:  sequence bit count
 //   data:   pointer to sequence bit data
-//   return: none
+//   return: number of generated bits (less than count when aborted)
 #if ((DAP_SWD != 0) || (DAP_JTAG != 0))
-void SWJ_Sequence (uint32_t count, uint8_t *data) {
+uint32_t SWJ_Sequence (uint32_t count, uint8_t *data) {
   uint32_t val;
   uint32_t n;
+  uint32_t i;
 
   val = 0;
   n = 0;
-  while (count--) {
+  for (i = 0; i < count; i++) {
     if (n == 0) {
+      if (DAP_TransferAbort) break;
       val = *data++;
       n = 8;
     }
@@ -71,6 +74,8 @@ void SWJ_Sequence (uint32_t count, uint8_t *data) {
     val >>= 1;
     n--;
   }
+
+  return (i);
 }
 #endif
 
@@ -78,6 +83,26 @@ void SWJ_Sequence (uint32_t count, uint8_t *data) {
 #if (DAP_SWD != 0)
 
 
+// SWD Packet Request for all APnDP/RnW/A2/A3 combinations (sent LSB first)
+//   bit 0: Start, bit 1: APnDP, bit 2: RnW, bits 3..4: A[3:2],
+//   bit 5: Parity, bit 6: Stop, bit 7: Park
+static const uint8_t SWD_Request[16] = {
+  0x81, 0xA3, 0xA5, 0x87, 0xA9, 0x8B, 0x8D, 0xAF,
+  0xB1, 0x93, 0x95, 0xB7, 0x99, 0xBB, 0xBD, 0x9F
+};
+
+
+// Calculate parity of a 32-bit word
+//   val:    data word
+//   return: parity bit
+static __inline uint32_t SWD_Parity (uint32_t val) {
+  val ^= val >> 16;
+  val ^= val >>  8;
+  val ^= val >>  4;
+  return ((0x6996 >> (val & 0x0F)) & 1);
+}
+
+
 // SWD Transfer I/O
 //   request: A[3:2] RnW APnDP
 //   data:    DATA[31:0]
@@ -92,27 +117,15 @@ uint8_t SWD_Transfer##speed (uint32_t request, uint32_t *data) {
   uint32_t n;                                                                   \
                                                                                 \
   /* Packet Request */                                                          \
-  parity = 0;                                                                   \
-  SW_WRITE_BIT(1);                      /* Start Bit */                         \
-  bit = request >> 0;                                                           \
-  SW_WRITE_BIT(bit);                    /* APnDP Bit */                         \
-  parity += bit;                                                                \
-  bit = request >> 1;                                                           \
-  SW_WRITE_BIT(bit);                    /* RnW Bit */                           \
-  parity += bit;                                                                \
-  bit = request >> 2;                                                           \
-  SW_WRITE_BIT(bit);                    /* A2 Bit */                            \
-  parity += bit;                                                                \
-  bit = request >> 3;                                                           \
-  SW_WRITE_BIT(bit);                    /* A3 Bit */                            \
-  parity += bit;                                                                \
-  SW_WRITE_BIT(parity);                 /* Parity Bit */                        \
-  SW_WRITE_BIT(0);                      /* Stop Bit */                          \
-  SW_WRITE_BIT(1);                      /* Park Bit */                          \
+  val = SWD_Request[request & 0x0F];                                            \
+  for (n = 8; n; n--) {                                                         \
+    SW_WRITE_BIT(val);                  /* Write Request Bit */                 \
+    val >>= 1;                                                                  \
+  }                                                                             \
                                                                                 \
   /* Turnaround */                                                              \
   PIN_SWDIO_OUT_DISABLE();                                                      \
-  for (n = DAP_Data.swd_conf.turnaround; n; n--) {                              \
+  for (n = SWD_TURNAROUND; n; n--) {                                            \
     SW_CLOCK_CYCLE();                                                           \
   }                                                                             \
                                                                                 \
@@ -129,41 +142,38 @@ uint8_t SWD_Transfer##speed (uint32_t request, uint32_t *data) {
     if (request & DAP_TRANSFER_RnW) {                                           \
       /* Read data */                                                           \
       val = 0;                                                                  \
-      parity = 0;                                                               \
       for (n = 32; n; n--) {                                                    \
         SW_READ_BIT(bit);               /* Read RDATA[0:31] */                  \
-        parity += bit;                                                          \
         val >>= 1;                                                              \
         val  |= bit << 31;                                                      \
       }                                                                         \
       SW_READ_BIT(bit);                 /* Read Parity */                       \
-      if ((parity ^ bit) & 1) {                                                 \
+      if ((SWD_Parity(val) ^ bit) & 1) {                                        \
         ack = DAP_TRANSFER_ERROR;                                               \
       }                                                                         \
       if (data) *data = val;                                                    \
       /* Turnaround */                                                          \
-      for (n = DAP_Data.swd_conf.turnaround; n; n--) {                          \
+      for (n = SWD_TURNAROUND; n; n--) {                                        \
         SW_CLOCK_CYCLE();                                                       \
       }                                                                         \
       PIN_SWDIO_OUT_ENABLE();                                                   \
     } else {                                                                    \
       /* Turnaround */                                                          \
-      for (n = DAP_Data.swd_conf.turnaround; n; n--) {                          \
+      for (n = SWD_TURNAROUND; n; n--) {                                        \
         SW_CLOCK_CYCLE();                                                       \
       }                                                                         \
       PIN_SWDIO_OUT_ENABLE();                                                   \
       /* Write data */                                                          \
       val = *data;                                                              \
-      parity = 0;                                                               \
+      parity = SWD_Parity(val);                                                 \
       for (n = 32; n; n--) {                                                    \
         SW_WRITE_BIT(val);              /* Write WDATA[0:31] */                 \
-        parity += val;                                                          \
         val >>= 1;                                                              \
       }                                                                         \
       SW_WRITE_BIT(parity);             /* Write Parity Bit */                  \
     }                                                                           \
     /* Idle cycles */                                                           \
-    n = DAP_Data.transfer.idle_cycles;                                          \
+    n = SWD_IDLE_CYCLES;                                                        \
     if (n) {                                                                    \
       PIN_SWDIO_OUT(0);                                                         \
       for (; n; n--) {                                                          \
@@ -176,17 +186,17 @@ uint8_t SWD_Transfer##speed (uint32_t request, uint32_t *data) {
                                                                                 \
   if ((ack == DAP_TRANSFER_WAIT) || (ack == DAP_TRANSFER_FAULT)) {              \
     /* WAIT or FAULT response */                                                \
-    if (DAP_Data.swd_conf.data_phase && ((request & DAP_TRANSFER_RnW) != 0)) {  \
+    if (SWD_DATA_PHASE && ((request & DAP_TRANSFER_RnW) != 0)) {                \
       for (n = 32+1; n; n--) {                                                  \
         SW_CLOCK_CYCLE();               /* Dummy Read RDATA[0:31] + Parity */   \
       }                                                                         \
     }                                                                           \
     /* Turnaround */                                                            \
-    for (n = DAP_Data.swd_conf.turnaround; n; n--) {                            \
+    for (n = SWD_TURNAROUND; n; n--) {                                          \
       SW_CLOCK_CYCLE();                                                         \
     }                                                                           \
     PIN_SWDIO_OUT_ENABLE();                                                     \
-    if (DAP_Data.swd_conf.data_phase && ((request & DAP_TRANSFER_RnW) == 0)) {  \
+    if (SWD_DATA_PHASE && ((request & DAP_TRANSFER_RnW) == 0)) {                \
       PIN_SWDIO_OUT(0);                                                         \
       for (n = 32+1; n; n--) {                                                  \
         SW_CLOCK_CYCLE();               /* Dummy Write WDATA[0:31] + Parity */  \
@@ -197,7 +207,7 @@ uint8_t SWD_Transfer##speed (uint32_t request, uint32_t *data) {
   }                                                                             \
                                                                                 \
   /* Protocol error */                                                          \
-  for (n = DAP_Data.swd_conf.turnaround + 32 + 1; n; n--) {                     \
+  for (n = SWD_TURNAROUND + 32 + 1; n; n--) {                                   \
     SW_CLOCK_CYCLE();                   /* Back off data phase */               \
   }                                                                             \
   PIN_SWDIO_OUT(1);                                                             \
@@ -205,6 +215,11 @@ uint8_t SWD_Transfer##speed (uint32_t request, uint32_t *data) {
 }
 
 
+// Configurable SWD transfer (settings loaded from DAP_Data)
+#define SWD_TURNAROUND  DAP_Data.swd_conf.turnaround
+#define SWD_DATA_PHASE  DAP_Data.swd_conf.data_phase
+#define SWD_IDLE_CYCLES DAP_Data.transfer.idle_cycles
+
 #undef  PIN_DELAY
 #define PIN_DELAY() PIN_DELAY_FAST()
 SWD_TransferFunction(Fast);
@@ -213,17 +228,54 @@ SWD_TransferFunction(Fast);
 #define PIN_DELAY() PIN_DELAY_SLOW(DAP_Data.clock_delay)
 SWD_TransferFunction(Slow);
 
+// Default SWD transfer (turnaround 1, no data phase, no idle cycles)
+#undef  SWD_TURNAROUND
+#undef  SWD_DATA_PHASE
+#undef  SWD_IDLE_CYCLES
+#define SWD_TURNAROUND  1
+#define SWD_DATA_PHASE  0
+#define SWD_IDLE_CYCLES 0
+
+#undef  PIN_DELAY
+#define PIN_DELAY() PIN_DELAY_FAST()
+SWD_TransferFunction(FastDefault);
+
+#undef  PIN_DELAY
+#define PIN_DELAY() PIN_DELAY_SLOW(DAP_Data.clock_delay)
+SWD_TransferFunction(SlowDefault);
+
+
+// Selected SWD transfer function
+static uint8_t (*SWD_TransferSelected)(uint32_t request, uint32_t *data) = SWD_TransferSlow;
+
+
+// Select SWD transfer function for current clock and transfer settings
+//   return:  none
+void SWD_TransferSelect(void) {
+  if ((DAP_Data.swd_conf.turnaround  == 1) &&
+      (DAP_Data.swd_conf.data_phase  == 0) &&
+      (DAP_Data.transfer.idle_cycles == 0)) {
+    SWD_TransferSelected = DAP_Data.fast_clock ? SWD_TransferFastDefault : SWD_TransferSlowDefault;
+  } else {
+    SWD_TransferSelected = DAP_Data.fast_clock ? SWD_TransferFast : SWD_TransferSlow;
+  }
+}
+
 
 // SWD Transfer I/O
 //   request: A[3:2] RnW APnDP
 //   data:    DATA[31:0]
 //   return:  ACK[2:0]
 uint8_t  SWD_Transfer(uint32_t request, uint32_t *data) {
-  if (DAP_Data.fast_clock) {
-    return SWD_TransferFast(request, data);
-  } else {
-    return SWD_TransferSlow(request, data);
-  }
+#if (DAP_PROFILE != 0)
+  uint8_t ack;
+
+  ack = SWD_TransferSelected(request, data);
+  DAP_ProfileAck(ack);
+  return (ack);
+#else
+  return SWD_TransferSelected(request, data);
+#endif
 }
 
 
@@ -0,0 +1,284 @@
+/* CMSIS-DAP Interface Firmware
+ * Copyright (c) 2009-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <RTL.h>
+#include <rl_usb.h>
+#include "DAP_config.h"
+#include "DAP.h"
+
+#if (DAP_WATCH != 0)
+
+#if (DAP_REG_CACHE == 0)
+#error "Watcher requires the DP/AP register cache (DAP_REG_CACHE)"
+#endif
+
+// Event watcher
+// A list of conditions (AP, address, mask, value) is polled while the debugger
+// does not use the DAP link, e.g. DHCSR with S_HALT to detect a halted core.
+// A condition which starts to match is reported on the bulk event endpoint
+// and by the Status command, so the debugger does not need to poll itself.
+// Note: reading DHCSR clears its sticky S_RETIRE_ST and S_RESET_ST bits, see
+// WatchCommand for how they are passed on to the debugger.
+// Failed reads are reported per condition; the sticky errors they leave in
+// the DP are cleared when the host state is restored.
+
+#define WATCH_CONDITIONS        4       // Maximum number of conditions
+#define WATCH_CONDITION_SIZE    13      // Condition in request (AP, address, mask, value)
+
+#define DHCSR                   0xE000EDF0      // Debug Halting Control and Status Register
+#define DHCSR_S_STICKY_Pos      24              // S_RETIRE_ST (bit 24), S_RESET_ST (bit 25)
+#define DHCSR_S_STICKY_Msk      (3 << DHCSR_S_STICKY_Pos)
+
+// Watch commands
+#define WATCH_STOP              0       // Stop watcher
+#define WATCH_START             1       // Set conditions and start watcher
+#define WATCH_STATUS            2       // Read and clear events
+
+typedef struct {
+  uint8_t   ap;                                 // MEM-AP index
+  uint32_t  csw;                                // MEM-AP CSW (32-bit)
+  uint32_t  addr;                               // Address
+  uint32_t  mask;                               // Value mask
+  uint32_t  value;                              // Value to match (after mask)
+} WatchCondition_t;
+
+static struct {
+  uint8_t   num;                                // Number of conditions (0 = stopped)
+  uint8_t   match;                              // Conditions matching at last poll
+  uint8_t   error;                              // Conditions not read at last poll
+  uint8_t   dhcsr;                              // DHCSR S_RETIRE_ST (bit 0) and S_RESET_ST (bit 1) read
+  uint8_t   events;                             // Events not read with Status
+  uint8_t   notify;                             // Events not sent on the endpoint
+  uint32_t  interval;                           // Poll interval in cycles (0 = continuous)
+  uint32_t  last;                               // Cycle Counter at last poll
+  uint32_t  data[WATCH_CONDITIONS];             // Values at last poll
+  WatchCondition_t cond[WATCH_CONDITIONS];      // Conditions
+} Watch;
+
+// Event packet for the bulk event endpoint
+// The main loop writes the packet while its length is 0 and the USB interrupt
+// clears the length after the packet was sent.
+static          uint8_t  WatchEvent[6 + 4*WATCH_CONDITIONS];
+static volatile uint32_t WatchEventLen;
+static volatile uint8_t  WatchEventBusy;
+
+
+// Put 32-bit value into data as little endian
+static uint8_t *Store32(uint8_t *data, uint32_t value) {
+  *data++ = (uint8_t)(value >>  0);
+  *data++ = (uint8_t)(value >>  8);
+  *data++ = (uint8_t)(value >> 16);
+  *data++ = (uint8_t)(value >> 24);
+  return (data);
+}
+
+
+// Write watcher report (events, match, error, DHCSR sticky bits, count, values)
+//   data:    pointer to report data
+//   events:  reported events
+//   return:  number of bytes in report
+static uint32_t WatchReport(uint8_t *data, uint8_t events) {
+  uint32_t n;
+
+  *(data+0) = events;
+  *(data+1) = Watch.match;
+  *(data+2) = Watch.error;
+  *(data+3) = Watch.dhcsr;
+  *(data+4) = Watch.num;
+  data += 5;
+  for (n = 0; n < Watch.num; n++) {
+    data = Store32(data, Watch.data[n]);
+  }
+  return (5 + 4*Watch.num);
+}
+
+
+// Poll watcher conditions
+// Must only be called while the debugger does not use the DAP link. DP SELECT
+// and MEM-AP registers are restored after the accesses.
+//   budget:  maximum number of polls
+//   return:  number of polls
+uint32_t watch_process(uint32_t budget) {
+  DAP_HostState_t host;
+  WatchCondition_t *cond;
+  uint8_t  data[4];
+  uint32_t done;
+  uint8_t  match;
+  uint8_t  error;
+  uint32_t n;
+
+  if ((Watch.num == 0) || (budget == 0)) {
+    return (0);
+  }
+  if (Watch.interval && ((DWT->CYCCNT - Watch.last) < Watch.interval)) {
+    return (0);
+  }
+  Watch.last = DWT->CYCCNT;
+
+  match = 0;
+  error = 0;
+  for (n = 0; n < Watch.num; n++) {
+    cond = &Watch.cond[n];
+    if (!DAP_SaveHostState(cond->ap, &host)) {
+      return (0);
+    }
+    if ((DAP_ReadMemory(cond->ap, cond->csw, cond->addr, data, 1, &done) == DAP_TRANSFER_OK) && done) {
+      Watch.data[n] = data[0] | (data[1] << 8) | (data[2] << 16) | (data[3] << 24);
+      if (cond->addr == DHCSR) {
+        Watch.dhcsr |= (Watch.data[n] & DHCSR_S_STICKY_Msk) >> DHCSR_S_STICKY_Pos;
+      }
+      if ((Watch.data[n] & cond->mask) == cond->value) {
+        match |= 1 << n;
+      }
+    } else {
+      error |= 1 << n;
+    }
+    DAP_RestoreHostState(cond->ap, &host);
+  }
+
+  // Report conditions which started to match
+  Watch.events |= match & ~Watch.match;
+  Watch.notify |= match & ~Watch.match;
+  Watch.match   = match;
+  Watch.error   = error;
+
+  if (Watch.notify && (WatchEventLen == 0)) {
+    WatchEvent[0] = ID_DAP_Vendor_Watch;
+    n = 1 + WatchReport(&WatchEvent[1], Watch.notify);
+    Watch.notify  = 0;
+    WatchEventLen = n;
+  }
+
+  return (1);
+}
+
+
+// USB Bulk Callback: when the event endpoint needs data (USB interrupt)
+//   buf:      pointer to data pointer
+//   max:      maximum number of bytes (endpoint packet size)
+//   return:   number of bytes to send
+int usbd_bulk_event_get_inbuf(U8 **buf, int max) {
+
+  // Release sent event
+  if (WatchEventBusy) {
+    WatchEventBusy = 0;
+    WatchEventLen  = 0;
+  }
+
+  if ((WatchEventLen == 0) || (WatchEventLen > (uint32_t)max)) {
+    return (0);
+  }
+
+  *buf = WatchEvent;
+  WatchEventBusy = 1;
+  return (WatchEventLen);
+}
+
+
+// Process Watch command and prepare response
+// Start replaces the conditions; a condition is a MEM-AP index followed by the
+// 32-bit address, mask and value. Status returns the events since the last
+// Status followed by the conditions matching and not read at the last poll,
+// the DHCSR S_RETIRE_ST (bit 0) and S_RESET_ST (bit 1) flags read since the
+// last Status and the values read. Status clears the events and DHCSR flags.
+// Note: the DHCSR flags are also cleared for the debugger by the polls, it
+// has to take them from Status while a DHCSR condition is watched.
+//   request:  pointer to request data (command, for start: poll interval in
+//             us (32-bit, 0 = continuous), number of conditions, conditions)
+//   response: pointer to response data
+//   return:   number of bytes in response (lower 16 bits)
+//             number of bytes in request (upper 16 bits)
+uint32_t WatchCommand(uint8_t *request, uint8_t *response) {
+  DAP_HostState_t host;
+  WatchCondition_t *cond;
+  uint32_t interval;
+  uint32_t saved;
+  uint32_t num;
+  uint32_t n;
+  uint8_t  status;
+  uint8_t *data;
+
+  status = DAP_OK;
+  switch (*request) {
+    case WATCH_STOP:
+      Watch.num = 0;
+      *response = status;
+      return ((1 << 16) | 1);
+
+    case WATCH_START:
+      interval = (*(request+1) <<  0) |
+                 (*(request+2) <<  8) |
+                 (*(request+3) << 16) |
+                 (*(request+4) << 24);
+      if (interval > (0x7FFFFFFF / (CPU_CLOCK/1000000))) {
+        interval = 0x7FFFFFFF / (CPU_CLOCK/1000000);
+      }
+      num = *(request+5);
+      if ((num == 0) || (num > WATCH_CONDITIONS)) {
+        *response = DAP_ERROR;
+        return ((6 << 16) | 1);
+      }
+
+      Watch.num = 0;
+      data = request + 6;
+      for (n = 0; n < num; n++, data += WATCH_CONDITION_SIZE) {
+        cond = &Watch.cond[n];
+        cond->ap    = *data;
+        cond->addr  = (*(data+1) <<  0) | (*(data+2) <<  8) | (*(data+3) << 16) | (*(data+4) << 24);
+        cond->mask  = (*(data+5) <<  0) | (*(data+6) <<  8) | (*(data+7) << 16) | (*(data+8) << 24);
+        cond->value = (*(data+9) <<  0) | (*(data+10) << 8) | (*(data+11) << 16) | (*(data+12) << 24);
+        cond->value &= cond->mask;
+        if (cond->ap >= DAP_REG_CACHE) {
+          status = DAP_ERROR;       // Host state of the AP can not be restored
+          continue;
+        }
+        // Keep the host view of the registers when it is known
+        saved = DAP_SaveHostState(cond->ap, &host);
+        if (DAP_MemoryCSW(cond->ap, CSW_SIZE32, &cond->csw) != DAP_TRANSFER_OK) {
+          status = DAP_ERROR;
+        }
+        if (saved) {
+          DAP_RestoreHostState(cond->ap, &host);
+        }
+      }
+
+      if (status == DAP_OK) {
+        // Conditions which already match are reported on the first poll
+        Watch.match    = 0;
+        Watch.error    = 0;
+        Watch.dhcsr    = 0;
+        Watch.events   = 0;
+        Watch.notify   = 0;
+        Watch.interval = interval * (CPU_CLOCK/1000000);
+        Watch.last     = DWT->CYCCNT - Watch.interval;
+        Watch.num      = num;
+      }
+      *response = status;
+      return (((6 + WATCH_CONDITION_SIZE*num) << 16) | 1);
+
+    case WATCH_STATUS:
+      *response = status;
+      n = 1 + WatchReport(response + 1, Watch.events);
+      Watch.events = 0;
+      Watch.dhcsr  = 0;
+      return ((1 << 16) | n);
+  }
+
+  *response = DAP_ERROR;
+  return ((1 << 16) | 1);
+}
+
+#endif  /* (DAP_WATCH != 0) */
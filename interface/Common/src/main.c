@@ -25,7 +25,24 @@
 #include "DAP_config.h"
 #include "DAP.h"
 
-extern void usbd_hid_process (void);
+extern uint32_t usbd_hid_process (void);
+extern uint32_t usbd_bulk_process (void);
+extern uint32_t usbd_hid_busy (void);
+extern uint32_t usbd_bulk_busy (void);
+#endif
+
+#if defined(CONF_DAP) && (DAP_PC_SAMPLE != 0)
+extern uint32_t pc_sample_process (uint32_t budget);
+#endif
+
+#if defined(CONF_DAP) && (DAP_WATCH != 0)
+extern uint32_t watch_process (uint32_t budget);
+#endif
+
+#if defined(CONF_DAP) && defined(CONF_CDC) && (DAP_RTT != 0)
+#define RTT_CDC         1       // CDC serial port bridged to the RTT console
+extern uint32_t rtt_process (uint32_t budget);
+extern uint32_t rtt_active (void);
 #endif
 
 #if defined(CONF_CDC)
@@ -34,35 +51,158 @@ extern void usbd_hid_process (void);
 
 #define SIZE_DATA (64)
 
-void serial_process() {
+// Move data between USB CDC and UART
+//   budget: maximum number of bytes per direction
+//   return: number of bytes moved
+uint32_t serial_process (uint32_t budget) {
     uint8_t data[SIZE_DATA];
     int32_t len_data = 0;
+    uint32_t num = 0;
+    uint32_t sent = 0;
+    uint32_t rece = 0;
 
-    while (1) {
+#if defined(RTT_CDC)
+    if (rtt_active()) {
+        return (0);     // CDC serial port is used by the RTT console
+    }
+#endif
 
-        len_data = USBD_CDC_ACM_DataFree();
-        if (len_data > SIZE_DATA)
-            len_data = SIZE_DATA;
-        if (len_data)
-            len_data = uart_read_data(data, len_data);
-        if (len_data) {
-            USBD_CDC_ACM_DataSend(data , len_data);
+    do {
+        len_data = 0;
+        if (sent < budget) {
+            len_data = USBD_CDC_ACM_DataFree();
+            if (len_data > SIZE_DATA)
+                len_data = SIZE_DATA;
+            if (len_data)
+                len_data = uart_read_data(data, len_data);
+            if (len_data) {
+                USBD_CDC_ACM_DataSend(data , len_data);
+                sent += len_data;
+            }
         }
+        num = len_data;
 
-        len_data = uart_write_free();
-        if (len_data > SIZE_DATA)
-            len_data = SIZE_DATA;
-        if (len_data)
-            len_data = USBD_CDC_ACM_DataRead(data, len_data);
-        if (len_data) {
-            uart_write_data(data, len_data);
+        len_data = 0;
+        if (rece < budget) {
+            len_data = uart_write_free();
+            if (len_data > SIZE_DATA)
+                len_data = SIZE_DATA;
+            if (len_data)
+                len_data = USBD_CDC_ACM_DataRead(data, len_data);
+            if (len_data) {
+                uart_write_data(data, len_data);
+                rece += len_data;
+            }
         }
+        num += len_data;
+    } while (num);
+
+    return (sent + rece);
+}
+#endif
+
+
+// Service Scheduler
+// Services run to completion within their budget; each pass of the main loop
+// runs all services once. DAP gets its budget again while requests are pending.
+
+#define DAP_BUDGET      4       // DAP packets per pass
+#define DAP_PRIORITY    2       // DAP passes per pass of other services
+#define CDC_BUDGET      256     // CDC/UART bytes per direction and pass
+#define RTT_BUDGET      64      // RTT/CDC bytes per direction and pass
+#define PCS_BUDGET      16      // PC samples per pass
+#define WATCH_BUDGET    1       // Watcher polls per pass
+
+#if defined(CONF_DAP)
+// Process DAP packets
+//   budget: maximum number of packets
+//   return: number of packets processed
+static uint32_t dap_process (uint32_t budget) {
+    uint32_t num = 0;
+
+    while ((num < budget) && usbd_hid_process()) {
+        num++;
+    }
+    return (num);
+}
+
+// Process DAP packets received on the bulk (WinUSB) interface
+//   budget: maximum number of packets
+//   return: number of packets processed
+static uint32_t dap_bulk_process (uint32_t budget) {
+    uint32_t num = 0;
+
+    while ((num < budget) && usbd_bulk_process()) {
+        num++;
     }
+    return (num);
+}
+
+// DAP link is idle when no requests are pending on either interface
+static uint32_t dap_idle (void) {
+    return (!usbd_hid_busy() && !usbd_bulk_busy());
 }
 #endif
 
+#if defined(RTT_CDC)
+// Poll the RTT console while the DAP link is idle
+//   budget: maximum number of bytes per direction
+//   return: number of bytes moved
+static uint32_t dap_rtt_process (uint32_t budget) {
+    return (dap_idle() ? rtt_process(budget) : 0);
+}
+#endif
+
+#if defined(CONF_DAP) && (DAP_PC_SAMPLE != 0)
+// Take PC samples while the DAP link is idle
+//   budget: maximum number of samples
+//   return: number of samples taken
+static uint32_t dap_pc_sample_process (uint32_t budget) {
+    return (dap_idle() ? pc_sample_process(budget) : 0);
+}
+#endif
+
+#if defined(CONF_DAP) && (DAP_WATCH != 0)
+// Poll the watcher conditions while the DAP link is idle
+//   budget: maximum number of polls
+//   return: number of polls
+static uint32_t dap_watch_process (uint32_t budget) {
+    return (dap_idle() ? watch_process(budget) : 0);
+}
+#endif
+
+typedef struct {
+    uint32_t (*process)(uint32_t budget);   // Service function
+    uint32_t   budget;                      // Work budget per pass
+    uint32_t   priority;                    // Passes while service is busy
+} Service_t;
+
+static const Service_t Service[] = {
+#if defined(CONF_DAP)
+    { dap_process,      DAP_BUDGET, DAP_PRIORITY },
+    { dap_bulk_process, DAP_BUDGET, DAP_PRIORITY },
+#endif
+#if defined(CONF_CDC)
+    { serial_process,   CDC_BUDGET, 1            },
+#endif
+#if defined(RTT_CDC)
+    { dap_rtt_process,  RTT_BUDGET, 1            },
+#endif
+#if defined(CONF_DAP) && (DAP_PC_SAMPLE != 0)
+    { dap_pc_sample_process, PCS_BUDGET, 1       },
+#endif
+#if defined(CONF_DAP) && (DAP_WATCH != 0)
+    { dap_watch_process, WATCH_BUDGET, 1         },
+#endif
+};
+
+#define SERVICE_NUM     (sizeof(Service) / sizeof(Service[0]))
+
+
 // Main program
 int main (void) {
+  uint32_t i, n;
+
 #if defined(CONF_DAP)
   DAP_Setup();                          // DAP Setup 
 #endif
@@ -82,11 +222,8 @@ int main (void) {
 #endif
 
   while (1) {                           // Endless Loop
-#if defined(CONF_DAP)
-    usbd_hid_process();                 // Process USB HID Data
-#endif
-#if defined(CONF_CDC)
-    serial_process();                   // Process USB CDC Data
-#endif
+    for (i = 0; i < SERVICE_NUM; i++) { // Run each service within its budget
+      for (n = Service[i].priority; n && Service[i].process(Service[i].budget); n--);
+    }
   }
 }
@@ -150,6 +150,18 @@
 //                                            <4=>   4        <5=>   5 <6=>   6 <7=>   7
 //                                            <8=>   8        <9=>   9 <10=> 10 <11=> 11
 //                                            <12=>  12       <13=> 13 <14=> 14 <15=> 15
+//         <o9.0..4> SWO Trace In Endpoint Number             <0=> Not used
+//                                            <1=>   1 <2=>   2 <3=>   3 <4=>   4
+//                                            <5=>   5 <6=>   6 <7=>   7 <8=>   8
+//                                            <9=>   9 <10=> 10 <11=> 11 <12=> 12
+//                                            <13=> 13 <14=> 14 <15=> 15
+//           <i> Streams SWO trace data to the host (needs a free endpoint)
+//         <o10.0..4> Event In Endpoint Number                <0=> Not used
+//                                            <1=>   1 <2=>   2 <3=>   3 <4=>   4
+//                                            <5=>   5 <6=>   6 <7=>   7 <8=>   8
+//                                            <9=>   9 <10=> 10 <11=> 11 <12=> 12
+//                                            <13=> 13 <14=> 14 <15=> 15
+//           <i> Interrupt endpoint for watcher notifications (needs a free endpoint)
 //         <h> Endpoint Settings
 //           <o3> Maximum Packet Size <1-1024>
 //           <e4> High-speed
@@ -181,6 +193,76 @@
                                     "microcontroller " \
                                     "1.0 "
 
+//     <e0.0> Bulk DAP Interface (WinUSB)
+//       <i> Enable vendor class interface with bulk endpoints carrying DAP packets
+//       <i> Microsoft OS 2.0 descriptors bind the interface to the WinUSB driver
+//       <h> Bulk Endpoint Settings
+//         <o1.0..4> Bulk In Endpoint Number                  <1=>   1 <2=>   2 <3=>   3
+//                                            <4=>   4        <5=>   5 <6=>   6 <7=>   7
+//                                            <8=>   8        <9=>   9 <10=> 10 <11=> 11
+//                                            <12=>  12       <13=> 13 <14=> 14 <15=> 15
+//         <o2.0..4> Bulk Out Endpoint Number                 <1=>   1 <2=>   2 <3=>   3
+//                                            <4=>   4        <5=>   5 <6=>   6 <7=>   7
+//                                            <8=>   8        <9=>   9 <10=> 10 <11=> 11
+//                                            <12=>  12       <13=> 13 <14=> 14 <15=> 15
+//         <o9.0..4> SWO Trace In Endpoint Number             <0=> Not used
+//                                            <1=>   1 <2=>   2 <3=>   3 <4=>   4
+//                                            <5=>   5 <6=>   6 <7=>   7 <8=>   8
+//                                            <9=>   9 <10=> 10 <11=> 11 <12=> 12
+//                                            <13=> 13 <14=> 14 <15=> 15
+//           <i> Streams SWO trace data to the host (needs a free endpoint)
+//         <o10.0..4> Event In Endpoint Number                <0=> Not used
+//                                            <1=>   1 <2=>   2 <3=>   3 <4=>   4
+//                                            <5=>   5 <6=>   6 <7=>   7 <8=>   8
+//                                            <9=>   9 <10=> 10 <11=> 11 <12=> 12
+//                                            <13=> 13 <14=> 14 <15=> 15
+//           <i> Interrupt endpoint for watcher notifications (needs a free endpoint)
+//         <h> Endpoint Settings
+//           <o3> Maximum Packet Size <1-1024>
+//           <e4> High-speed
+//             <i> If high-speed is enabled set endpoint settings for it
+//             <o5> Maximum Packet Size <1-1024>
+//             <o6> Maximum NAK Rate <0-255>
+//           </e>
+//         </h>
+//       </h>
+//       <h> Bulk DAP Interface Settings
+//         <i> Device specific settings
+//         <s0.126> Bulk Interface String
+//           <i> Debuggers recognize the interface by "CMSIS-DAP" in this string
+//         <o7.0..7> Microsoft OS 2.0 Vendor Request Code <1-255>
+//           <i> bRequest used by Windows to read the Microsoft OS 2.0 descriptor set
+//         <o8.0..15> Maximum Transfer Size (in bytes) <1-65535>
+//           <i> Must be a multiple of the maximum packet sizes
+//       </h>
+//     </e>
+#if !defined(CONF_DAP)
+#define USBD_BULK_ENABLE            0
+#else
+#define USBD_BULK_ENABLE            1
+#endif
+#define USBD_BULK_EP_BULKIN         2
+#define USBD_BULK_EP_BULKOUT        2
+#define USBD_BULK_WMAXPACKETSIZE    64
+#define USBD_BULK_HS_ENABLE         0
+#define USBD_BULK_HS_WMAXPACKETSIZE 512
+#define USBD_BULK_HS_BINTERVAL      0
+#define USBD_BULK_STRDESC           L"MBED CMSIS-DAP v2"
+#define USBD_BULK_VENDOR_CODE       0x20
+#define USBD_BULK_MAX_TRANSFER      64
+#if defined(TARGET_MK20D5)
+#define USBD_BULK_EP_SWOIN          5
+#define USBD_BULK_EP_EVENTIN        6
+#else
+#define USBD_BULK_EP_SWOIN          0
+#define USBD_BULK_EP_EVENTIN        0
+#endif
+#define USBD_BULK_EVENT_BINTERVAL   1
+#define USBD_BULK_EVENT_HS_BINTERVAL 4
+#if (((USBD_BULK_HS_ENABLE) && (USBD_BULK_MAX_TRANSFER % USBD_BULK_HS_WMAXPACKETSIZE)) || (USBD_BULK_MAX_TRANSFER % USBD_BULK_WMAXPACKETSIZE))
+#error "Bulk maximum transfer size must be a multiple of Bulk maximum packet size!"
+#endif
+
 //     <e0.0> Audio Device (ADC)
 //       <i> Enable class support for Audio Device (ADC)
 //       <h> Isochronous Endpoint Settings
@@ -332,8 +414,8 @@
 
 /* USB Device Calculations ---------------------------------------------------*/
 
-#define USBD_IF_NUM                (USBD_HID_ENABLE+USBD_MSC_ENABLE+(USBD_ADC_ENABLE*2)+(USBD_CDC_ACM_ENABLE*2)+USBD_CLS_ENABLE)
-#define USBD_MULTI_IF              (USBD_CDC_ACM_ENABLE*(USBD_HID_ENABLE|USBD_MSC_ENABLE|USBD_ADC_ENABLE))
+#define USBD_IF_NUM                (USBD_HID_ENABLE+USBD_MSC_ENABLE+USBD_BULK_ENABLE+(USBD_ADC_ENABLE*2)+(USBD_CDC_ACM_ENABLE*2)+USBD_CLS_ENABLE)
+#define USBD_MULTI_IF              (USBD_CDC_ACM_ENABLE*(USBD_HID_ENABLE|USBD_MSC_ENABLE|USBD_BULK_ENABLE|USBD_ADC_ENABLE))
 #define MAX(x, y)                (((x) < (y)) ? (y) : (x))
 #define USBD_EP_NUM_CALC0           MAX((USBD_HID_ENABLE    *(USBD_HID_EP_INTIN     )), (USBD_HID_ENABLE    *(USBD_HID_EP_INTOUT!=0)*(USBD_HID_EP_INTOUT)))
 #define USBD_EP_NUM_CALC1           MAX((USBD_MSC_ENABLE    *(USBD_MSC_EP_BULKIN    )), (USBD_MSC_ENABLE    *(USBD_MSC_EP_BULKOUT)))
@@ -342,7 +424,10 @@
 #define USBD_EP_NUM_CALC4           MAX(USBD_EP_NUM_CALC0, USBD_EP_NUM_CALC1)
 #define USBD_EP_NUM_CALC5           MAX(USBD_EP_NUM_CALC2, USBD_EP_NUM_CALC3)
 #define USBD_EP_NUM_CALC6           MAX(USBD_EP_NUM_CALC4, USBD_EP_NUM_CALC5)
-#define USBD_EP_NUM                (USBD_EP_NUM_CALC6)
+#define USBD_EP_NUM_CALC7           MAX((USBD_BULK_ENABLE   *(USBD_BULK_EP_BULKIN   )), (USBD_BULK_ENABLE   *(USBD_BULK_EP_BULKOUT)))
+#define USBD_EP_NUM_CALC8           MAX(USBD_EP_NUM_CALC7, (USBD_BULK_ENABLE   *(USBD_BULK_EP_SWOIN    )))
+#define USBD_EP_NUM_CALC9           MAX(USBD_EP_NUM_CALC8, (USBD_BULK_ENABLE   *(USBD_BULK_EP_EVENTIN  )))
+#define USBD_EP_NUM                (MAX(USBD_EP_NUM_CALC6, USBD_EP_NUM_CALC9))
 
 #if    (USBD_HID_ENABLE)
 #if    (USBD_MSC_ENABLE)
@@ -403,6 +488,44 @@
 #endif
 #endif
 
+#if    (USBD_BULK_ENABLE)
+#if   ((USBD_HID_ENABLE     && ((USBD_BULK_EP_BULKIN == USBD_HID_EP_INTIN)       || \
+                                (USBD_BULK_EP_BULKIN == USBD_HID_EP_INTOUT)      || \
+                                (USBD_BULK_EP_BULKOUT == USBD_HID_EP_INTIN)      || \
+                                (USBD_BULK_EP_BULKOUT == USBD_HID_EP_INTOUT)))   || \
+       (USBD_MSC_ENABLE     && ((USBD_BULK_EP_BULKIN == USBD_MSC_EP_BULKIN)      || \
+                                (USBD_BULK_EP_BULKOUT == USBD_MSC_EP_BULKOUT)))  || \
+       (USBD_CDC_ACM_ENABLE && ((USBD_BULK_EP_BULKIN == USBD_CDC_ACM_EP_INTIN)   || \
+                                (USBD_BULK_EP_BULKIN == USBD_CDC_ACM_EP_BULKIN)  || \
+                                (USBD_BULK_EP_BULKOUT == USBD_CDC_ACM_EP_INTIN)  || \
+                                (USBD_BULK_EP_BULKOUT == USBD_CDC_ACM_EP_BULKOUT))))
+#error "Bulk DAP Interface can not use same Endpoints as other classes!"
+#endif
+#if    (USBD_BULK_EP_SWOIN)
+#if   ((USBD_BULK_EP_SWOIN == USBD_BULK_EP_BULKIN)                            || \
+       (USBD_BULK_EP_SWOIN == USBD_BULK_EP_BULKOUT)                           || \
+       (USBD_HID_ENABLE     && ((USBD_BULK_EP_SWOIN == USBD_HID_EP_INTIN)    || \
+                                (USBD_BULK_EP_SWOIN == USBD_HID_EP_INTOUT))) || \
+       (USBD_MSC_ENABLE     &&  (USBD_BULK_EP_SWOIN == USBD_MSC_EP_BULKIN))  || \
+       (USBD_CDC_ACM_ENABLE && ((USBD_BULK_EP_SWOIN == USBD_CDC_ACM_EP_INTIN) || \
+                                (USBD_BULK_EP_SWOIN == USBD_CDC_ACM_EP_BULKIN))))
+#error "Bulk SWO Trace Endpoint can not use same Endpoint as other classes!"
+#endif
+#endif
+#if    (USBD_BULK_EP_EVENTIN)
+#if   ((USBD_BULK_EP_EVENTIN == USBD_BULK_EP_BULKIN)                          || \
+       (USBD_BULK_EP_EVENTIN == USBD_BULK_EP_BULKOUT)                         || \
+       (USBD_BULK_EP_EVENTIN == USBD_BULK_EP_SWOIN)                           || \
+       (USBD_HID_ENABLE     && ((USBD_BULK_EP_EVENTIN == USBD_HID_EP_INTIN)  || \
+                                (USBD_BULK_EP_EVENTIN == USBD_HID_EP_INTOUT)))|| \
+       (USBD_MSC_ENABLE     &&  (USBD_BULK_EP_EVENTIN == USBD_MSC_EP_BULKIN))|| \
+       (USBD_CDC_ACM_ENABLE && ((USBD_BULK_EP_EVENTIN == USBD_CDC_ACM_EP_INTIN) || \
+                                (USBD_BULK_EP_EVENTIN == USBD_CDC_ACM_EP_BULKIN))))
+#error "Bulk Event Endpoint can not use same Endpoint as other classes!"
+#endif
+#endif
+#endif
+
 #define USBD_ADC_CIF_NUM           (0)
 #define USBD_ADC_SIF1_NUM          (1)
 #define USBD_ADC_SIF2_NUM          (2)
@@ -410,6 +533,7 @@
 #define USBD_CDC_ACM_DIF_NUM       (USBD_ADC_ENABLE*2+1)
 #define USBD_HID_IF_NUM            (USBD_ADC_ENABLE*2+USBD_CDC_ACM_ENABLE*2)
 #define USBD_MSC_IF_NUM            (USBD_ADC_ENABLE*2+USBD_CDC_ACM_ENABLE*2+USBD_HID_ENABLE)
+#define USBD_BULK_IF_NUM           (USBD_ADC_ENABLE*2+USBD_CDC_ACM_ENABLE*2+USBD_HID_ENABLE+USBD_MSC_ENABLE)
 
 #define USBD_ADC_CIF_STR_NUM       (3+USBD_STRDESC_SER_ENABLE+0)
 #define USBD_ADC_SIF1_STR_NUM      (3+USBD_STRDESC_SER_ENABLE+1)
@@ -418,6 +542,7 @@
 #define USBD_CDC_ACM_DIF_STR_NUM   (3+USBD_STRDESC_SER_ENABLE+USBD_ADC_ENABLE*3+1)
 #define USBD_HID_IF_STR_NUM        (3+USBD_STRDESC_SER_ENABLE+USBD_ADC_ENABLE*3+USBD_CDC_ACM_ENABLE*2)
 #define USBD_MSC_IF_STR_NUM        (3+USBD_STRDESC_SER_ENABLE+USBD_ADC_ENABLE*3+USBD_CDC_ACM_ENABLE*2+USBD_HID_ENABLE)
+#define USBD_BULK_IF_STR_NUM       (3+USBD_STRDESC_SER_ENABLE+USBD_ADC_ENABLE*3+USBD_CDC_ACM_ENABLE*2+USBD_HID_ENABLE+USBD_MSC_ENABLE)
 
 #if    (USBD_HID_ENABLE)
 #if    (USBD_HID_HS_ENABLE)
@@ -437,6 +562,15 @@
 #else
 #define USBD_MSC_MAX_PACKET        (0)
 #endif
+#if    (USBD_BULK_ENABLE)
+#if    (USBD_BULK_HS_ENABLE)
+#define USBD_BULK_MAX_PACKET      ((USBD_BULK_HS_WMAXPACKETSIZE > USBD_BULK_WMAXPACKETSIZE) ? USBD_BULK_HS_WMAXPACKETSIZE : USBD_BULK_WMAXPACKETSIZE)
+#else
+#define USBD_BULK_MAX_PACKET       (USBD_BULK_WMAXPACKETSIZE)
+#endif
+#else
+#define USBD_BULK_MAX_PACKET       (0)
+#endif
 #if    (USBD_ADC_ENABLE)
 #if    (USBD_ADC_HS_ENABLE)
 #define USBD_ADC_MAX_PACKET       ((USBD_ADC_HS_WMAXPACKETSIZE > USBD_ADC_WMAXPACKETSIZE) ? USBD_ADC_HS_WMAXPACKETSIZE : USBD_ADC_WMAXPACKETSIZE)
@@ -461,7 +595,7 @@
 #define USBD_CDC_ACM_MAX_PACKET    (0)
 #define USBD_CDC_ACM_MAX_PACKET1   (0)
 #endif
-#define USBD_MAX_PACKET_CALC0     ((USBD_HID_MAX_PACKET   > USBD_HID_MAX_PACKET      ) ? (USBD_HID_MAX_PACKET  ) : (USBD_HID_MAX_PACKET      ))
+#define USBD_MAX_PACKET_CALC0     ((USBD_HID_MAX_PACKET   > USBD_BULK_MAX_PACKET     ) ? (USBD_HID_MAX_PACKET  ) : (USBD_BULK_MAX_PACKET     ))
 #define USBD_MAX_PACKET_CALC1     ((USBD_ADC_MAX_PACKET   > USBD_CDC_ACM_MAX_PACKET  ) ? (USBD_ADC_MAX_PACKET  ) : (USBD_CDC_ACM_MAX_PACKET  ))
 #define USBD_MAX_PACKET_CALC2     ((USBD_MAX_PACKET_CALC0 > USBD_MAX_PACKET_CALC1    ) ? (USBD_MAX_PACKET_CALC0) : (USBD_MAX_PACKET_CALC1    ))
 #define USBD_MAX_PACKET           ((USBD_MAX_PACKET_CALC2 > USBD_CDC_ACM_MAX_PACKET1 ) ? (USBD_MAX_PACKET_CALC2) : (USBD_CDC_ACM_MAX_PACKET1 ))
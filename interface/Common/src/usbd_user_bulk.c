@@ -0,0 +1,90 @@
+/* CMSIS-DAP Interface Firmware
+ * Copyright (c) 2009-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <RTL.h>
+#include <rl_usb.h>
+#include <usb.h>
+#define __NO_USB_LIB_C
+#ifdef TARGET_LPC4320
+#include "usb_config_hs.c"
+#else
+#include "usb_config.c"
+#endif
+#include "DAP_config.h"
+#include "DAP.h"
+#include "DAP_queue.h"
+
+
+#if (USBD_BULK_ENABLE)
+
+#if (USBD_BULK_MAX_TRANSFER != DAP_PACKET_SIZE)
+#error "USB Bulk Transfer Size must match DAP Packet Size"
+#endif
+
+static DAP_Queue_t USB_Queue;                   // DAP Packet Queue
+
+
+// Start sending a response
+static uint32_t usbd_bulk_send_packet (uint8_t *buf, uint32_t len) {
+    return (usbd_bulk_send(buf, len));
+}
+
+// USB Bulk Callback: when system initializes or device is configured
+void usbd_bulk_init (void) {
+    DAP_QueueInit(&USB_Queue, usbd_bulk_send_packet);
+}
+
+// USB Bulk Callback: when previous response is sent
+//   Response buffer is sent directly and released after transmission
+int usbd_bulk_get_inbuf (U8 **buf) {
+    return (DAP_QueueResponseSent(&USB_Queue, buf));
+}
+
+// USB Bulk Callback: when request reception starts
+//   Request is received directly into request buffer (see DAP_QueueRequestBuf).
+U8 *usbd_bulk_get_outbuf (void) {
+    return (DAP_QueueRequestBuf(&USB_Queue));
+}
+
+// USB Bulk Callback: when request is received from the host
+void usbd_bulk_received (U8 *buf, int len) {
+    DAP_QueueReceived(&USB_Queue, buf, len);
+}
+
+
+// Check for DAP requests in progress
+//   return: 1 when requests are pending or a vendor command continues
+uint32_t usbd_bulk_busy (void) {
+    return (DAP_QueueBusy(&USB_Queue));
+}
+
+
+// Process USB Bulk Data
+//   return: 1 when a packet was processed, 0 when idle
+uint32_t usbd_bulk_process (void) {
+    return (DAP_QueueProcess(&USB_Queue));
+}
+
+#else
+
+uint32_t usbd_bulk_busy (void) {
+    return (0);
+}
+
+uint32_t usbd_bulk_process (void) {
+    return (0);
+}
+
+#endif  /* (USBD_BULK_ENABLE) */
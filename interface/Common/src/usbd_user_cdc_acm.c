@@ -18,6 +18,15 @@
 
 #include "uart.h"
 
+#if defined(CONF_DAP)
+#include "DAP_config.h"
+#endif
+
+#if defined(CONF_DAP) && (SWO_UART != 0)
+#define SWO_CDC         1       // UART shared by SWO capture and CDC serial port
+extern uint32_t swo_active (void);
+#endif
+
 
 UART_Configuration UART_Config;
 
@@ -64,13 +73,18 @@ int32_t USBD_CDC_ACM_PortReset (void) {
 /** \brief  Virtual COM Port change communication settings
 
     The function changes communication settings of the port used as the
-    Virtual COM Port.
+    Virtual COM Port. The settings are rejected while SWO capture uses the UART.
 
     \param [in]         line_coding  Pointer to the loaded CDC_LINE_CODING structure.
     \return             0        Function failed.
     \return             1        Function succeeded.
  */
 int32_t USBD_CDC_ACM_PortSetLineCoding (CDC_LINE_CODING *line_coding) {
+#if defined(SWO_CDC)
+    if (swo_active()) {
+        return (0);     // UART is configured by SWO capture
+    }
+#endif
     UART_Config.Baudrate    = line_coding->dwDTERate;
     UART_Config.DataBits    = (UART_DataBits) line_coding->bDataBits;
     UART_Config.Parity      = (UART_Parity)   line_coding->bParityType;
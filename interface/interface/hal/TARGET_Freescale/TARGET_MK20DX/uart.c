@@ -15,6 +15,7 @@
  */
 #include <MK20D5.h>
 #include "uart.h"
+#include "ring.h"
 #include <string.h>
 
 extern uint32_t SystemCoreClock;
@@ -23,29 +24,26 @@ static void clear_buffers(void);
 
 // Size must be 2^n for using quick wrap around
 #define  BUFFER_SIZE          (512)
+#define  BUFFER_IDX(cnt)      RING_IDX(cnt, BUFFER_SIZE)
 
+// Written by the main loop and read by the UART interrupt (write_buffer)
+// or the other way round (read_buffer)
 struct {
     uint8_t  data[BUFFER_SIZE];
-    volatile uint32_t idx_in;
-    volatile uint32_t idx_out;
-    volatile uint32_t cnt_in;
-    volatile uint32_t cnt_out;
+    Ring_t   ring;
 } write_buffer, read_buffer;
 
 uint32_t tx_in_progress = 0;
 
+// Received data bypasses read_buffer while a handler is installed
+static UART_ReceiveHandler rx_handler;
+
 void clear_buffers(void)
 {
     memset((void*)&read_buffer, 0xBB, sizeof(read_buffer.data));
-    read_buffer.idx_in = 0;
-    read_buffer.idx_out = 0;
-    read_buffer.cnt_in = 0;
-    read_buffer.cnt_out = 0;
+    ring_init(&read_buffer.ring);
     memset((void*)&write_buffer, 0xBB, sizeof(read_buffer.data));
-    write_buffer.idx_in = 0;
-    write_buffer.idx_out = 0;
-    write_buffer.cnt_in = 0;
-    write_buffer.cnt_out = 0;
+    ring_init(&write_buffer.ring);
 }
 
 int32_t uart_initialize (void) {
@@ -177,28 +175,27 @@ int32_t uart_get_configuration (UART_Configuration *config) {
 
 int32_t uart_write_free(void) {
 
-    return BUFFER_SIZE - (write_buffer.cnt_in - write_buffer.cnt_out);
+    return ring_free(&write_buffer.ring, BUFFER_SIZE);
 }
 
 int32_t uart_write_data (uint8_t *data, uint16_t size) {
     uint32_t cnt;
-    int16_t  len_in_buf;
+    uint32_t in;
+    uint32_t n;
 
     if (size == 0) {
         return 0;
     }
 
-    cnt = 0;
-
-    while (size--) {
-        len_in_buf = write_buffer.cnt_in - write_buffer.cnt_out;
-        if (len_in_buf < BUFFER_SIZE) {
-            write_buffer.data[write_buffer.idx_in++] = *data++;
-            write_buffer.idx_in &= (BUFFER_SIZE - 1);
-            write_buffer.cnt_in++;
-            cnt++;
-        }
+    cnt = ring_free(&write_buffer.ring, BUFFER_SIZE);
+    if (cnt > size) {
+        cnt = size;
+    }
+    in = write_buffer.ring.in;
+    for (n = 0; n < cnt; n++) {
+        write_buffer.data[BUFFER_IDX(in + n)] = *data++;
     }
+    ring_put(&write_buffer.ring, cnt);
 
     if (!tx_in_progress)
     {
@@ -208,9 +205,8 @@ int32_t uart_write_data (uint8_t *data, uint16_t size) {
         tx_in_progress = 1;
 
         // Write the first byte into D
-        UART1->D = write_buffer.data[write_buffer.idx_out++];
-        write_buffer.idx_out &= (BUFFER_SIZE - 1);
-        write_buffer.cnt_out++;
+        UART1->D = write_buffer.data[BUFFER_IDX(write_buffer.ring.out)];
+        ring_get(&write_buffer.ring, 1);
 
         // enable TX interrupt
         UART1->C2 |= UART_C2_TIE_MASK;
@@ -221,43 +217,49 @@ int32_t uart_write_data (uint8_t *data, uint16_t size) {
 
 int32_t uart_read_data (uint8_t *data, uint16_t size) {
     uint32_t cnt;
+    uint32_t out;
+    uint32_t n;
 
     if (size == 0) {
         return 0;
     }
 
-    cnt = 0;
-
-    while (size--) {
-        if (read_buffer.cnt_in != read_buffer.cnt_out) {
-            *data++ = read_buffer.data[read_buffer.idx_out++];
-            read_buffer.idx_out &= (BUFFER_SIZE - 1);
-            read_buffer.cnt_out++;
-            cnt++;
-        }
-        else
-        {
-            break;
-        }
+    cnt = ring_count(&read_buffer.ring);
+    if (cnt > size) {
+        cnt = size;
+    }
+    out = read_buffer.ring.out;
+    for (n = 0; n < cnt; n++) {
+        *data++ = read_buffer.data[BUFFER_IDX(out + n)];
     }
+    ring_get(&read_buffer.ring, cnt);
 
     return cnt;
 }
 
+int32_t uart_set_receive_handler (UART_ReceiveHandler handler) {
+    NVIC_DisableIRQ(UART1_RX_TX_IRQn);
+    rx_handler = handler;
+    ring_init(&read_buffer.ring);
+    NVIC_EnableIRQ(UART1_RX_TX_IRQn);
+
+    return 1;
+}
+
 void UART1_RX_TX_IRQHandler (void) {
     uint32_t s1;
     volatile uint8_t errorData;
+    uint8_t  ch;
 
     // read interrupt status
     s1 = UART1->S1;
 
     // handle character to transmit
-    if (write_buffer.cnt_in != write_buffer.cnt_out) {
+    if (ring_count(&write_buffer.ring)) {
         // if TDRE is empty
         if (s1 & UART_S1_TDRE_MASK) {
-            UART1->D = write_buffer.data[write_buffer.idx_out++];
-            write_buffer.idx_out &= (BUFFER_SIZE - 1);
-            write_buffer.cnt_out++;
+            UART1->D = write_buffer.data[BUFFER_IDX(write_buffer.ring.out)];
+            ring_get(&write_buffer.ring, 1);
             tx_in_progress = 1;
         }
     }
@@ -275,9 +277,15 @@ void UART1_RX_TX_IRQHandler (void) {
         }
         else
         {
-            read_buffer.data[read_buffer.idx_in++] = UART1->D;
-            read_buffer.idx_in &= (BUFFER_SIZE - 1);
-            read_buffer.cnt_in++;
+            ch = UART1->D;
+            if (rx_handler) {
+                rx_handler(&ch, 1);
+            }
+            // if buffer full: drop received character
+            else if (ring_free(&read_buffer.ring, BUFFER_SIZE)) {
+                read_buffer.data[BUFFER_IDX(read_buffer.ring.in)] = ch;
+                ring_put(&read_buffer.ring, 1);
+            }
         }
     }
 }
@@ -33,6 +33,14 @@ uint8_t OutEpSize[USBD_EP_NUM + 1];
 
 uint32_t Data1  = 0x55555555;
 
+/* Ping-pong buffering: the SIE alternates between the two BDs (banks) of each
+   endpoint direction. Bulk and interrupt IN endpoints queue a packet in the
+   second bank while the first one is sent, OUT endpoints keep both banks
+   ready for reception. EP0 uses one bank at a time.                          */
+uint32_t BankSIE  = 0;                  /* bank used next by the SIE          */
+uint32_t BankUser = 0;                  /* bank filled (IN)/read (OUT) next   */
+uint8_t  InPending[USBD_EP_NUM + 1];    /* IN packets with event pending      */
+
 #define BD_OWN_MASK        0x80
 #define BD_DATA01_MASK     0x40
 #define BD_KEEP_MASK       0x20
@@ -45,6 +53,8 @@ uint32_t Data1  = 0x55555555;
 #define ODD   0
 #define EVEN  1
 #define IDX(Ep, dir, Ev_Odd) ((((Ep & 0x0F) * 4) + (2 * dir) + (1 *  Ev_Odd)))
+#define BANK_BIT(Ep, dir)    (1UL << (((Ep & 0x0F) * 2) + dir))
+#define BANK(mask, Ep, dir)  ((mask & BANK_BIT(Ep, dir)) ? 1 : 0)
 
 #define SETUP_TOKEN    0x0D
 #define IN_TOKEN       0x09
@@ -146,24 +156,34 @@ void USBD_Reset (void) {
   for (i = 1; i < 16; i++) {
     USB0->ENDPOINT[i].ENDPT = 0x00;
   }
+  for (i = 0; i < USBD_EP_NUM + 1; i++) {
+    InPending[i] = 0;
+  }
+
+  Data1    = 0x55555555;
+  BankSIE  = 0;
+  BankUser = 0;
+  USB0->CTL    |=  USB_CTL_ODDRST_MASK; /* SIE starts with bank 0 of all EPs */
+  USB0->CTL    &= ~USB_CTL_ODDRST_MASK;
 
   /* EP0 control endpoint                                                     */
   BD[IDX(0, RX, ODD )].bc       = USBD_MAX_PACKET0;
   BD[IDX(0, RX, ODD )].buf_addr = (uint32_t) &(EPBuf[IDX(0, RX, ODD )][0]);
   BD[IDX(0, RX, ODD )].stat     = BD_OWN_MASK | BD_DTS_MASK | BD_DATA01_MASK;
 
+  BD[IDX(0, RX, EVEN)].bc       = USBD_MAX_PACKET0;
+  BD[IDX(0, RX, EVEN)].buf_addr = (uint32_t) &(EPBuf[IDX(0, RX, EVEN)][0]);
   BD[IDX(0, RX, EVEN)].stat     = 0;
 
+  BD[IDX(0, TX, ODD )].stat     = 0;
+  BD[IDX(0, TX, EVEN)].stat     = 0;
   BD[IDX(0, TX, ODD )].buf_addr = (uint32_t) &(EPBuf[IDX(0, TX, ODD )][0]);
-  BD[IDX(0, TX, EVEN)].buf_addr = 0;
+  BD[IDX(0, TX, EVEN)].buf_addr = (uint32_t) &(EPBuf[IDX(0, TX, EVEN)][0]);
 
   USB0->ENDPOINT[0].ENDPT = USB_ENDPT_EPHSHK_MASK | /* enable ep handshaking  */
                             USB_ENDPT_EPTXEN_MASK | /* enable TX (IN) tran.   */
                             USB_ENDPT_EPRXEN_MASK;  /* enable RX (OUT) tran.  */
 
-  Data1 = 0x55555555;
-  USB0->CTL    |=  USB_CTL_ODDRST_MASK;
-
   USB0->ISTAT   =  0xFF;                /* clear all interrupt status flags   */
   USB0->ERRSTAT =  0xFF;                /* clear all error flags              */
   USB0->ERREN   =  0xFF;                /* enable error interrupt sources     */
@@ -327,19 +347,33 @@ void USBD_DisableEP (uint32_t EPNum) {
  */
 
 void USBD_ResetEP (uint32_t EPNum) {
+  uint32_t bank;
+
   if (EPNum & 0x80) {
     EPNum &= 0x0F;
     Data1 |= (1 << ((EPNum * 2) + 1));
+    BD[IDX(EPNum, TX, ODD )].stat     = 0;
+    BD[IDX(EPNum, TX, EVEN)].stat     = 0;
     BD[IDX(EPNum, TX, ODD )].buf_addr = (uint32_t) &(EPBuf[IDX(EPNum, TX, ODD )][0]);
-    BD[IDX(EPNum, TX, EVEN)].buf_addr = 0;
+    BD[IDX(EPNum, TX, EVEN)].buf_addr = (uint32_t) &(EPBuf[IDX(EPNum, TX, EVEN)][0]);
+    InPending[EPNum] = 0;
+
+    /* next packet is queued in the bank the SIE uses next                    */
+    BankUser = (BankUser & ~BANK_BIT(EPNum, TX)) | (BankSIE & BANK_BIT(EPNum, TX));
   }
   else {
     Data1 &= ~(1 << ((EPNum * 2)));
-    BD[IDX(EPNum, RX, ODD )].bc       = OutEpSize[EPNum];
-    BD[IDX(EPNum, RX, ODD )].buf_addr = (uint32_t) &(EPBuf[IDX(EPNum, RX, ODD )][0]);
-    BD[IDX(EPNum, RX, ODD )].stat     = BD_OWN_MASK | BD_DTS_MASK;
+    bank = BANK(BankSIE, EPNum, RX);
+    BD[IDX(EPNum, RX, bank    )].bc       = OutEpSize[EPNum];
+    BD[IDX(EPNum, RX, bank    )].buf_addr = (uint32_t) &(EPBuf[IDX(EPNum, RX, bank    )][0]);
+    BD[IDX(EPNum, RX, bank    )].stat     = BD_OWN_MASK | BD_DTS_MASK;
+
+    /* other bank receives the following packet (DATA1), not used by EP0      */
+    BD[IDX(EPNum, RX, bank ^ 1)].bc       = OutEpSize[EPNum];
+    BD[IDX(EPNum, RX, bank ^ 1)].buf_addr = (uint32_t) &(EPBuf[IDX(EPNum, RX, bank ^ 1)][0]);
+    BD[IDX(EPNum, RX, bank ^ 1)].stat     = EPNum ? (BD_OWN_MASK | BD_DTS_MASK | BD_DATA01_MASK) : 0;
 
-    BD[IDX(EPNum, RX, EVEN)].stat     = 0;
+    BankUser = (BankUser & ~BANK_BIT(EPNum, RX)) | (BankSIE & BANK_BIT(EPNum, RX));
   }
 }
 
@@ -396,7 +430,7 @@ uint32_t USBD_ReadEP (uint32_t EPNum, uint8_t *pData) {
   uint32_t n, sz, idx, setup = 0;
 
 
-  idx = IDX(EPNum, RX, 0);
+  idx = IDX(EPNum, RX, BANK(BankUser, EPNum, RX));
   sz  = BD[idx].bc;
 
   if ((EPNum == 0) && (TOK_PID(idx) == SETUP_TOKEN)) setup = 1;
@@ -405,7 +439,16 @@ uint32_t USBD_ReadEP (uint32_t EPNum, uint8_t *pData) {
     pData[n] = EPBuf[idx][n];
   }
 
-  BD[idx].bc = OutEpSize[EPNum];
+  BankUser ^= BANK_BIT(EPNum, RX);      /* banks are filled alternately       */
+
+  /* Bulk and interrupt EP: bank receives the packet after next               */
+  if (EPNum) {
+    BD[idx].bc    = OutEpSize[EPNum];
+    BD[idx].stat  = (BD[idx].stat & BD_DATA01_MASK) | BD_DTS_MASK;
+    BD[idx].stat |= BD_OWN_MASK;
+    USB0->CTL &= ~USB_CTL_TXSUSPENDTOKENBUSY_MASK;
+    return (sz);
+  }
 
   if ((Data1 >> (idx / 2) & 1) == ((BD[idx].stat >> 6) & 1)) {
     if (setup && (pData[6] == 0))       /* if no setup data stage,            */
@@ -413,6 +456,10 @@ uint32_t USBD_ReadEP (uint32_t EPNum, uint8_t *pData) {
     else Data1 ^= (1 << (idx / 2));
   }
 
+  /* EP0: prepare the bank used next by the SIE                               */
+  idx = IDX(EPNum, RX, BANK(BankUser, EPNum, RX));
+  BD[idx].bc = OutEpSize[EPNum];
+
   if ((Data1 >> (idx / 2)) & 1) {
     BD[idx].stat  = BD_DTS_MASK | BD_DATA01_MASK;
     BD[idx].stat |= BD_OWN_MASK;
@@ -442,7 +489,10 @@ uint32_t USBD_WriteEP (uint32_t EPNum, uint8_t *pData, uint32_t cnt) {
 
   EPNum &=0x0F;
 
-  idx = IDX(EPNum, TX, 0);
+  idx = IDX(EPNum, TX, BANK(BankUser, EPNum, TX));
+  if (BD[idx].stat & BD_OWN_MASK) {     /* both banks are in use              */
+    return (0);
+  }
   BD[idx].bc = cnt;
   for (n = 0; n < cnt; n++) {
     EPBuf[idx][n] = pData[n];
@@ -454,6 +504,15 @@ uint32_t USBD_WriteEP (uint32_t EPNum, uint8_t *pData, uint32_t cnt) {
     BD[idx].stat = BD_OWN_MASK | BD_DTS_MASK | BD_DATA01_MASK;
   }
   Data1 ^= (1 << (idx / 2));
+  BankUser ^= BANK_BIT(EPNum, TX);
+
+  /* Bulk and interrupt EP: IN event as soon as a bank is free                */
+  if (EPNum) {
+    NVIC_DisableIRQ(USB0_IRQn);
+    InPending[EPNum]++;
+    NVIC_EnableIRQ (USB0_IRQn);
+    NVIC_SetPendingIRQ(USB0_IRQn);
+  }
   return(cnt);
 }
 
@@ -577,11 +636,20 @@ void USB0_IRQHandler(void) {
     dir    = (USB0->STAT >> 3) & 0x01;
     ev_odd = (USB0->STAT >> 2) & 0x01;
 
+    /* SIE continues with the other bank                                      */
+    if (ev_odd) {
+      BankSIE &= ~BANK_BIT(num, dir);
+    }
+    else {
+      BankSIE |=  BANK_BIT(num, dir);
+    }
+
 /* setup packet                                                               */
     if ((num == 0) && (TOK_PID((IDX(num, dir, ev_odd))) == SETUP_TOKEN)) {
       Data1 &= ~0x02;
       BD[IDX(0, TX, EVEN)].stat &= ~BD_OWN_MASK;
       BD[IDX(0, TX, ODD)].stat  &= ~BD_OWN_MASK;
+      BankUser = (BankUser & ~BANK_BIT(0, TX)) | (BankSIE & BANK_BIT(0, TX));
 #ifdef __RTX
         if (USBD_RTX_EPTask[num]) {
           isr_evt_set(USBD_EVT_SETUP, USBD_RTX_EPTask[num]);
@@ -607,8 +675,8 @@ void USB0_IRQHandler(void) {
 #endif
       }
 
-/* IN packet                                                                  */
-      if (TOK_PID((IDX(num, dir, ev_odd))) == IN_TOKEN) {
+/* IN packet (bulk and interrupt EP events are raised below)                  */
+      if ((TOK_PID((IDX(num, dir, ev_odd))) == IN_TOKEN) && (num == 0)) {
 #ifdef __RTX
         if (USBD_RTX_EPTask[num]) {
           isr_evt_set(USBD_EVT_IN,  USBD_RTX_EPTask[num]);
@@ -622,6 +690,23 @@ void USB0_IRQHandler(void) {
     }
     USB0->ISTAT = USB_ISTAT_TOKDNE_MASK;
   }
+
+/* IN packets queued: event for each packet as soon as a bank is free         */
+  for (num = 1; num < USBD_EP_NUM + 1; num++) {
+    if (InPending[num] &&
+        !(BD[IDX(num, TX, BANK(BankUser, num, TX))].stat & BD_OWN_MASK)) {
+      InPending[num]--;
+#ifdef __RTX
+      if (USBD_RTX_EPTask[num]) {
+        isr_evt_set(USBD_EVT_IN,  USBD_RTX_EPTask[num]);
+      }
+#else
+      if (USBD_P_EP[num]) {
+        USBD_P_EP[num](USBD_EVT_IN);
+      }
+#endif
+    }
+  }
 }
 
 
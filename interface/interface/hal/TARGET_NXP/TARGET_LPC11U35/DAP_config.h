@@ -53,6 +53,23 @@ Provides definitions about:
 /// required.
 #define IO_PORT_WRITE_CYCLES    2               ///< I/O Cycles: 2=default, 1=Cortex-M0+ fast I/0
 
+/// Pace the SWD/JTAG clock with the DWT cycle counter of the Debug Unit.
+/// Clock edges are scheduled on cycle counter deadlines so that the generated clock does not
+/// exceed the frequency set with \ref DAP_SWJ_Clock; it is lower when the I/O code takes longer
+/// than half a clock period. Requires a Cortex-M3/M4 processor with DWT.
+#define DAP_CYCLE_COUNTER       0               ///< Cycle Counter: 1 = DWT paced clock, 0 = delay loop
+
+/// Profile DAP commands with the DWT cycle counter of the Debug Unit.
+/// Invocations, cycles and failed SWD/JTAG transfer responses are accumulated per command ID
+/// and read with the vendor command Profile. Requires a Cortex-M3/M4 processor with DWT.
+#define DAP_PROFILE             0               ///< Profiling: 1 = enabled, 0 = disabled
+
+/// Limit WAIT retries by a time budget per command measured with the DWT cycle counter of the
+/// Debug Unit.
+/// The budget and an optional exponential backoff between retries are set with the vendor
+/// command TransferTimeout. Requires a Cortex-M3/M4 processor with DWT.
+#define DAP_WAIT_TIMEOUT        0               ///< WAIT time budget: 1 = enabled, 0 = disabled
+
 /// Indicate that Serial Wire Debug (SWD) communication mode is available at the Debug Access Port.
 /// This information is returned by the command \ref DAP_Info as part of <b>Capabilities</b>.
 #define DAP_SWD                 1               ///< SWD Mode:  1 = available, 0 = not available
@@ -86,8 +103,47 @@ Provides definitions about:
 /// Maximum Package Buffers for Command and Response data.
 /// This configuration settings is used to optimized the communication performance with the
 /// debugger and depends on the USB peripheral. For devices with limited RAM or USB buffer the
-/// setting can be reduced (valid range is 1 .. 255). Change setting to 4 for High-Speed USB.
-#define DAP_PACKET_COUNT        1              ///< Buffers: 64 = Full-Speed, 4 = High-Speed.
+/// setting can be reduced (power of two, valid range is 1 .. 128). Change setting to 4 for High-Speed USB.
+#define DAP_PACKET_COUNT        2              ///< Buffers: 64 = Full-Speed, 4 = High-Speed.
+
+/// Configure number of Access Ports with shadowed MEM-AP CSW and TAR registers.
+/// The Debug Unit shadows DP SELECT and the CSW/TAR registers of MEM-APs with APSEL below this
+/// value and acknowledges writes of unchanged values without a wire transfer.
+/// This setting impacts the RAM requirements of the Debug Unit. Valid range is 0 .. 255.
+#define DAP_REG_CACHE           4               ///< Shadowed Access Ports: 0 = cache disabled.
+
+/// Bridge channel 0 of a SEGGER RTT control block in target RAM to the CDC serial port.
+/// The control block is searched and polled while the debugger does not use the DAP link;
+/// the vendor command RTT starts the search. Requires CONF_CDC and the register cache.
+/// Disabled here: its reads nest about 200 bytes deep in the 512 byte stack of the LPC11U35.
+#define DAP_RTT                 0               ///< RTT console: 1 = enabled, 0 = disabled
+
+/// Sample the target PC from DWT_PCSR while the debugger does not use the DAP link.
+/// Samples are counted in a histogram on the Debug Unit and read with the vendor command
+/// PC_Sample. Requires a Cortex-M3/M4 processor with DWT and the register cache.
+#define DAP_PC_SAMPLE           0               ///< PC sampling: 1 = enabled, 0 = disabled
+
+/// Poll a list of target memory conditions (e.g. DHCSR halt state) while the debugger does
+/// not use the DAP link and report matches on the bulk event endpoint and with the vendor
+/// command Watch. Requires a Cortex-M3/M4 Debug Unit with DWT and the register cache.
+#define DAP_WATCH               0               ///< Event watcher: 1 = enabled, 0 = disabled
+
+/// Capture SWO trace data in UART (NRZ) mode with the UART of the Debug Unit.
+/// The UART is shared with the CDC serial port and the SWO signal must be wired to its RX pin.
+/// The trace is read with the command \ref DAP_SWO_Data or streamed on the bulk trace endpoint.
+#define SWO_UART                1               ///< SWO UART:  1 = available, 0 = not available
+
+/// Maximum SWO UART baudrate in Hz.
+#define SWO_UART_MAX_BAUDRATE   3000000         ///< SWO UART Maximum Baudrate in Hz
+
+/// SWO trace buffer size in bytes (power of two).
+/// This setting impacts the RAM requirements of the Debug Unit. The LPC11U35 has 8 KB SRAM for
+/// the firmware (estimate: HID and bulk DAP queues 2 x 340 bytes, UART rings 150 bytes, DAP data
+/// 200 bytes, USB stack 500 bytes, stack and heap 1 KB); 512 bytes hold 1.7 ms of 3 MBaud trace.
+#define SWO_BUFFER_SIZE         512             ///< SWO Trace Buffer Size in bytes
+
+/// Stream SWO trace data on the bulk trace endpoint (USBD_BULK_EP_SWOIN in usb_config.c).
+#define SWO_STREAM              0               ///< SWO Streaming Trace: 1 = available, 0 = not available
 
 /// Debug Unit is connected to fixed Target Device.
 /// The Debug Unit may be part of an evaluation board and always connected to a fixed
@@ -15,23 +15,27 @@
  */
 #include <LPC11Uxx.h>
 #include "uart.h"
+#include "ring.h"
 
 static uint32_t baudrate;
 static uint32_t dll;
 static uint32_t tx_in_progress;
 
+// Received data bypasses read_buffer while a handler is installed
+static UART_ReceiveHandler rx_handler;
+
 extern uint32_t SystemCoreClock;
 
 // Size must be 2^n
 #define  BUFFER_SIZE          (64)
+#define  BUFFER_IDX(cnt)      RING_IDX(cnt, BUFFER_SIZE)
 
 
+// Written by the main loop and read by the UART interrupt (write_buffer)
+// or the other way round (read_buffer)
 static struct {
     uint8_t  data[BUFFER_SIZE];
-    volatile uint16_t idx_in;
-    volatile uint16_t idx_out;
-    volatile  int16_t cnt_in;
-    volatile  int16_t cnt_out;
+    Ring_t   ring;
 } write_buffer, read_buffer;
 
 
@@ -291,27 +295,27 @@ int32_t uart_get_configuration (UART_Configuration *config) {
 }
 
 int32_t uart_write_free(void) {
-    return BUFFER_SIZE - (write_buffer.cnt_in - write_buffer.cnt_out);
+    return ring_free(&write_buffer.ring, BUFFER_SIZE);
 }
 
 int32_t uart_write_data (uint8_t *data, uint16_t size) {
     uint32_t cnt;
-    int16_t  len_in_buf;
+    uint32_t in;
+    uint32_t n;
 
     if (size == 0) {
         return 0;
     }
 
-    cnt = 0;
-    while (size--) {
-        len_in_buf = write_buffer.cnt_in - write_buffer.cnt_out;
-        if (len_in_buf < BUFFER_SIZE) {
-            write_buffer.data[write_buffer.idx_in++] = *data++;
-            write_buffer.idx_in &= (BUFFER_SIZE - 1);
-            write_buffer.cnt_in++;
-            cnt++;
-        }
+    cnt = ring_free(&write_buffer.ring, BUFFER_SIZE);
+    if (cnt > size) {
+        cnt = size;
     }
+    in = write_buffer.ring.in;
+    for (n = 0; n < cnt; n++) {
+        write_buffer.data[BUFFER_IDX(in + n)] = *data++;
+    }
+    ring_put(&write_buffer.ring, cnt);
 
     // enable THRE interrupt
     LPC_USART->IER |= (1 << 1);
@@ -327,39 +331,52 @@ int32_t uart_write_data (uint8_t *data, uint16_t size) {
 
 int32_t uart_read_data (uint8_t *data, uint16_t size) {
     uint32_t cnt;
+    uint32_t out;
+    uint32_t n;
 
     if (size == 0) {
         return 0;
     }
 
-    cnt = 0;
-    while (size--) {
-        if (read_buffer.cnt_in != read_buffer.cnt_out) {
-            *data++ = read_buffer.data[read_buffer.idx_out++];
-            read_buffer.idx_out &= (BUFFER_SIZE - 1);
-            read_buffer.cnt_out++;
-            cnt++;
-        }
+    cnt = ring_count(&read_buffer.ring);
+    if (cnt > size) {
+        cnt = size;
     }
+    out = read_buffer.ring.out;
+    for (n = 0; n < cnt; n++) {
+        *data++ = read_buffer.data[BUFFER_IDX(out + n)];
+    }
+    ring_get(&read_buffer.ring, cnt);
 
     return cnt;
 }
 
 
+int32_t uart_set_receive_handler (UART_ReceiveHandler handler) {
+    NVIC_DisableIRQ(UART_IRQn);
+    rx_handler = handler;
+    ring_init(&read_buffer.ring);
+    NVIC_EnableIRQ(UART_IRQn);
+
+    return 1;
+}
+
+
 void UART_IRQHandler (void) {
     uint32_t iir;
-    int16_t  len_in_buf;
+    uint8_t  ch;
+    uint8_t  rx[16];
+    uint32_t n;
 
     // read interrupt status
     iir = LPC_USART->IIR;
 
     // handle character to transmit
-    if (write_buffer.cnt_in != write_buffer.cnt_out) {
+    if (ring_count(&write_buffer.ring)) {
         // if THR is empty
         if (LPC_USART->LSR & (1 << 5)) {
-            LPC_USART->THR = write_buffer.data[write_buffer.idx_out++];
-            write_buffer.idx_out &= (BUFFER_SIZE - 1);
-            write_buffer.cnt_out++;
+            LPC_USART->THR = write_buffer.data[BUFFER_IDX(write_buffer.ring.out)];
+            ring_get(&write_buffer.ring, 1);
             tx_in_progress = 1;
         }
     } else if (tx_in_progress) {
@@ -371,16 +388,20 @@ void UART_IRQHandler (void) {
     // handle received character
     if (((iir & 0x0E) == 0x04)  ||        // Rx interrupt (RDA)
         ((iir & 0x0E) == 0x0C))  {        // Rx interrupt (CTI)
+        if (rx_handler) {
+            // pass the whole RX FIFO at once
+            for (n = 0; (n < sizeof(rx)) && (LPC_USART->LSR & 0x01); n++) {
+                rx[n] = LPC_USART->RBR;
+            }
+            rx_handler(rx, n);
+        }
         while (LPC_USART->LSR & 0x01) {
-            len_in_buf = read_buffer.cnt_in - read_buffer.cnt_out;
-            read_buffer.data[read_buffer.idx_in++] = LPC_USART->RBR;
-            read_buffer.idx_in &= (BUFFER_SIZE - 1);
-            read_buffer.cnt_in++;
-            // if buffer full: write by dropping oldest characters
-            if (len_in_buf == BUFFER_SIZE) {
-                read_buffer.idx_out++;
-                read_buffer.idx_out &= (BUFFER_SIZE - 1);
-                read_buffer.cnt_out++;
+            ch = LPC_USART->RBR;
+            // if buffer full: drop received character (oldest ones belong
+            // to the reader)
+            if (ring_free(&read_buffer.ring, BUFFER_SIZE)) {
+                read_buffer.data[BUFFER_IDX(read_buffer.ring.in)] = ch;
+                ring_put(&read_buffer.ring, 1);
             }
         }
     }
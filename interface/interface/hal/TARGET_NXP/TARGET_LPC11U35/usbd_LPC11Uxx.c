@@ -37,9 +37,16 @@
 #define EP_LIST_BASE       0x20004000
 #define EP_BUF_BASE        (U32)(EP_LIST_BASE + 0x100)
 
+/* Endpoints other than EP0 are double buffered: the firmware fills (IN) or
+   reads (OUT) one buffer while the hardware uses the other one. Buffers are
+   used alternately, starting with buffer 0 after EPINUSE is cleared.         */
 typedef struct BUF_INFO {
   U32  buf_len;
   U32  buf_ptr;
+  U32  buf_ptr1;                        /* second buffer (0: single buffered) */
+  U8   buf_sel;                         /* next buffer to fill (IN)/read (OUT)*/
+  U8   buf_cnt;                         /* IN: packets with event pending,
+                                           OUT: packets with event delivered  */
 }EP_BUF_INFO;
 
 EP_BUF_INFO EPBufInfo[(USBD_EP_NUM + 1) * 2];
@@ -65,6 +72,17 @@ U32 * GetEpCmdStatPtr (U32 EPNum) {
 }
 
 
+/*
+ *  Get number of buffers not active (in use by hardware) of double buffered EP
+ *    Parameters:    ptr: EP CmdStat pointer
+ *
+ */
+
+static U32 GetEpBufFree (U32 *ptr) {
+  return (((ptr[0] & BUF_ACTIVE) ? 0 : 1) + ((ptr[1] & BUF_ACTIVE) ? 0 : 1));
+}
+
+
 /*
  *  Usb interrupt enable/disable
  *    Parameters:      ena: enable/disable
@@ -149,6 +167,11 @@ void USBD_Reset (void) {
   for (i = 2; i < (5 * 4); i++) {
     EPList[i] = (1UL << 30);            /* EPs disabled                       */
   }
+  for (i = 2; i < ((USBD_EP_NUM + 1) * 2); i++) {
+    EPBufInfo[i].buf_ptr1 = 0;
+  }
+  LPC_USB->EPBUFCFG = 0;                /* single buffered EPs                */
+  LPC_USB->EPINUSE  = 0;
 
   EPBufInfo[0].buf_len = USBD_MAX_PACKET0;
   EPBufInfo[0].buf_ptr = EP_BUF_BASE;
@@ -263,7 +286,7 @@ void USBD_Configure (BOOL cfg) {
  */
 
 void USBD_ConfigEP (USB_ENDPOINT_DESCRIPTOR *pEPD) {
-  U32 num, val, type;
+  U32 num, val, type, idx;
   U32 * ptr;
 
   num  = pEPD->bEndpointAddress;
@@ -273,8 +296,9 @@ void USBD_ConfigEP (USB_ENDPOINT_DESCRIPTOR *pEPD) {
   /* IN EPs                                                                   */
   if (num & 0x80) {
     num &= ~0x80;
-    EPBufInfo[EP_IN_IDX(num)].buf_len  = val;
-    EPBufInfo[EP_IN_IDX(num)].buf_ptr  = addr;
+    idx  = EP_IN_IDX(num);
+    EPBufInfo[idx].buf_len  = val;
+    EPBufInfo[idx].buf_ptr  = addr;
 
     addr += ((val + 63) >> 6) * 64;     /* calc new free buffer address       */
 
@@ -287,18 +311,33 @@ void USBD_ConfigEP (USB_ENDPOINT_DESCRIPTOR *pEPD) {
 
   /* OUT EPs                                                                  */
   else {
-    EPBufInfo[EP_OUT_IDX(num)].buf_len  = val;
-    EPBufInfo[EP_OUT_IDX(num)].buf_ptr  = addr;
+    idx  = EP_OUT_IDX(num);
+    EPBufInfo[idx].buf_len  = val;
+    EPBufInfo[idx].buf_ptr  = addr;
 
     ptr  = GetEpCmdStatPtr(num);
-    *ptr = N_BYTES(EPBufInfo[EP_OUT_IDX(num)].buf_len) |
-           BUF_ADDR(EPBufInfo[EP_OUT_IDX(num)].buf_ptr)|
+    *ptr = N_BYTES(EPBufInfo[idx].buf_len) |
+           BUF_ADDR(EPBufInfo[idx].buf_ptr)|
            EP_DISABLED;
     if (type == USB_ENDPOINT_TYPE_ISOCHRONOUS) {
       *ptr |= EP_TYPE;
     }
     addr += ((val + 63) >> 6) * 64;     /* calc new free buffer address       */
   }
+
+  /* Second buffer for bulk and interrupt EPs                                 */
+  EPBufInfo[idx].buf_ptr1 = 0;
+  if (type == USB_ENDPOINT_TYPE_ISOCHRONOUS) {
+    LPC_USB->EPBUFCFG &= ~(1UL << idx);
+  }
+  else {
+    EPBufInfo[idx].buf_ptr1 = addr;
+    *(ptr + 1) = N_BYTES(EPBufInfo[idx].buf_len) |
+                 BUF_ADDR(EPBufInfo[idx].buf_ptr1)|
+                 EP_DISABLED;
+    addr += ((val + 63) >> 6) * 64;     /* calc new free buffer address       */
+    LPC_USB->EPBUFCFG |=  (1UL << idx);
+  }
 }
 
 
@@ -322,14 +361,24 @@ void USBD_DirCtrlEP (U32 dir) {
  */
 
 void USBD_EnableEP (U32 EPNum) {
-  U32 * ptr;;
+  U32 * ptr, idx;
 
   ptr = GetEpCmdStatPtr(EPNum);
+  idx = (EPNum & 0x80) ? EP_IN_IDX((EPNum & 0x7F)) : EP_OUT_IDX(EPNum);
+
+  if (EPBufInfo[idx].buf_ptr1) {        /* start with buffer 0                */
+    EPBufInfo[idx].buf_sel = 0;
+    EPBufInfo[idx].buf_cnt = 0;
+    LPC_USB->EPINUSE &= ~(1UL << idx);
+  }
 
   /* IN EP                                                                    */
   if (EPNum & 0x80) {
     EPNum &= ~0x80;
     *ptr &= ~EP_DISABLED;
+    if (EPBufInfo[idx].buf_ptr1) {
+      *(ptr + 1) &= ~EP_DISABLED;
+    }
     LPC_USB->INTSTAT = (1 << EP_IN_IDX(EPNum));
     LPC_USB->INTEN  |= (1 << EP_IN_IDX(EPNum));
   }
@@ -337,6 +386,10 @@ void USBD_EnableEP (U32 EPNum) {
   else {
     *ptr &= ~EP_DISABLED;
     *ptr |=  BUF_ACTIVE;
+    if (EPBufInfo[idx].buf_ptr1) {
+      *(ptr + 1) &= ~EP_DISABLED;
+      *(ptr + 1) |=  BUF_ACTIVE;
+    }
     LPC_USB->INTSTAT = (1 << EP_OUT_IDX(EPNum));
     LPC_USB->INTEN  |= (1 << EP_OUT_IDX(EPNum));
   }
@@ -356,6 +409,9 @@ void USBD_DisableEP (U32 EPNum) {
 
   ptr = GetEpCmdStatPtr(EPNum);
   *ptr = EP_DISABLED;
+  if (EPNum & 0x7F) {
+    *(ptr + 1) = EP_DISABLED;
+  }
 
   if (EPNum & 0x80) {
     EPNum &= 0x7F;
@@ -400,6 +456,8 @@ void USBD_SetStallEP (U32 EPNum) {
     if (*ptr & BUF_ACTIVE) {
       *ptr &= ~(BUF_ACTIVE);
     }
+    *(ptr + 1) &= ~(BUF_ACTIVE);
+    *(ptr + 1) |=  EP_STALL;
   }
   else {
     if (EPNum & 0x80) {
@@ -425,16 +483,29 @@ void USBD_SetStallEP (U32 EPNum) {
  */
 
 void USBD_ClrStallEP (U32 EPNum) {
-  U32 *ptr;
+  U32 *ptr, idx;
 
   ptr = GetEpCmdStatPtr(EPNum);
+  idx = (EPNum & 0x80) ? EP_IN_IDX((EPNum & 0x7F)) : EP_OUT_IDX(EPNum);
 
   if (EPNum & 0x80) {
     *ptr &=  ~EP_STALL;
+    if (EPBufInfo[idx].buf_ptr1) {
+      *(ptr + 1) &= ~EP_STALL;
+    }
   }
   else {
     *ptr &=  ~EP_STALL;
     *ptr |=   BUF_ACTIVE;
+    if (EPBufInfo[idx].buf_ptr1) {
+      *(ptr + 1) &= ~EP_STALL;
+      *(ptr + 1) |=  BUF_ACTIVE;
+    }
+  }
+  if (EPBufInfo[idx].buf_ptr1) {
+    EPBufInfo[idx].buf_sel = 0;
+    EPBufInfo[idx].buf_cnt = 0;
+    LPC_USB->EPINUSE &= ~(1UL << idx);
   }
   USBD_ResetEP(EPNum);
 }
@@ -480,7 +551,7 @@ void USBD_ClearEPBuf (U32 EPNum) {
  */
 
 U32 USBD_ReadEP (U32 EPNum, U8 *pData) {
-  U32 cnt, i;
+  U32 cnt, i, idx;
   U32 *dataptr, *ptr;
 
   ptr = GetEpCmdStatPtr(EPNum);
@@ -511,17 +582,33 @@ U32 USBD_ReadEP (U32 EPNum, U8 *pData) {
 
   /*OUT packet                                                                */
   else {
+    idx = EP_OUT_IDX(EPNum);
     ptr = GetEpCmdStatPtr(EPNum);
-    cnt = EPBufInfo[EP_OUT_IDX(EPNum)].buf_len - ((*ptr >> 16) & 0x3FF);
-    dataptr = (U32 *)EPBufInfo[EP_OUT_IDX(EPNum)].buf_ptr;
+    dataptr = (U32 *)EPBufInfo[idx].buf_ptr;
+
+    /* double buffered: read buffers in the order they were filled            */
+    if (EPBufInfo[idx].buf_ptr1) {
+      if (EPBufInfo[idx].buf_sel) {
+        ptr++;
+        dataptr = (U32 *)EPBufInfo[idx].buf_ptr1;
+      }
+      EPBufInfo[idx].buf_sel ^= 1;
+      NVIC_DisableIRQ(USB_IRQn);
+      if (EPBufInfo[idx].buf_cnt) {
+        EPBufInfo[idx].buf_cnt--;
+      }
+      NVIC_EnableIRQ(USB_IRQn);
+    }
+
+    cnt = EPBufInfo[idx].buf_len - ((*ptr >> 16) & 0x3FF);
 
     for (i = 0; i < (cnt + 3) / 4; i++) {
       *((__packed U32 *)pData) = dataptr[i];
       pData += 4;
     }
 
-    *ptr = N_BYTES(EPBufInfo[EP_OUT_IDX(EPNum)].buf_len) |
-           BUF_ADDR(EPBufInfo[EP_OUT_IDX(EPNum)].buf_ptr)|
+    *ptr = N_BYTES(EPBufInfo[idx].buf_len) |
+           BUF_ADDR((U32)dataptr)|
            BUF_ACTIVE;
   }
   return (cnt);
@@ -539,12 +626,49 @@ U32 USBD_ReadEP (U32 EPNum, U8 *pData) {
  */
 
 U32 USBD_WriteEP (U32 EPNum, U8 *pData, U32 cnt) {
-  U32 i;
+  U32 i, idx;
   U32 * dataptr, *ptr;
 
   ptr = GetEpCmdStatPtr(EPNum);
 
   EPNum &= ~0x80;
+  idx    = EP_IN_IDX(EPNum);
+
+  /* double buffered: fill next buffer while hardware sends the other one     */
+  if (EPBufInfo[idx].buf_ptr1) {
+    if (*ptr & EP_STALL) {
+      return (0);
+    }
+    dataptr = (U32 *)EPBufInfo[idx].buf_ptr;
+    if (EPBufInfo[idx].buf_sel) {
+      ptr++;
+      dataptr = (U32 *)EPBufInfo[idx].buf_ptr1;
+    }
+    if (*ptr & BUF_ACTIVE) {            /* both buffers are in use            */
+      return (0);
+    }
+
+    for (i = 0; i < (cnt + 3) / 4; i++) {
+      dataptr[i] = * ((__packed U32 *)pData);
+      pData += 4;
+    }
+
+    *ptr &= ~(0x3FFFFFF);
+    *ptr |=  BUF_ADDR((U32)dataptr)|
+             N_BYTES(cnt);
+    *ptr |=  BUF_ACTIVE;
+
+    /* IN event is generated as soon as a buffer is free for the next packet  */
+    EPBufInfo[idx].buf_sel ^= 1;
+    NVIC_DisableIRQ(USB_IRQn);
+    EPBufInfo[idx].buf_cnt++;
+    NVIC_EnableIRQ(USB_IRQn);
+    if (GetEpBufFree(GetEpCmdStatPtr(EPNum | 0x80))) {
+      LPC_USB->INTSETSTAT = (1UL << idx);
+    }
+
+    return (cnt);
+  }
 
   while (*ptr & BUF_ACTIVE);
 
@@ -706,6 +830,7 @@ void USB_IRQHandler (void) {
   if (sts & 0x3FF) {
     for (num = 0; num < ((USBD_EP_NUM + 1) * 2); num++) {
       if (sts & (1UL << num)) {
+        LPC_USB->INTSTAT = (1UL << num);
 
         val = LPC_USB->DEVCMDSTAT;
   /*Setup                                                                     */
@@ -723,6 +848,17 @@ void USB_IRQHandler (void) {
 
   /*OUT                                                                       */
         else if ((num % 2) == 0) {
+          /* double buffered: one event for each received packet             */
+          if (EPBufInfo[num].buf_ptr1) {
+            val = GetEpBufFree((U32 *)&EPList[num * 2]);
+            if (val <= EPBufInfo[num].buf_cnt) {
+              continue;
+            }
+            EPBufInfo[num].buf_cnt++;
+            if (val > EPBufInfo[num].buf_cnt) {
+              LPC_USB->INTSETSTAT = (1UL << num);
+            }
+          }
 #ifdef __RTX
           if (USBD_RTX_EPTask[num / 2]) {
             isr_evt_set(USBD_EVT_OUT, USBD_RTX_EPTask[num / 2]);
@@ -736,6 +872,14 @@ void USB_IRQHandler (void) {
 
   /*IN                                                                        */
         else {
+          /* double buffered: one event for each packet once a buffer is free */
+          if (EPBufInfo[num].buf_ptr1) {
+            if (!EPBufInfo[num].buf_cnt ||
+                !GetEpBufFree((U32 *)&EPList[num * 2])) {
+              continue;
+            }
+            EPBufInfo[num].buf_cnt--;
+          }
 #ifdef __RTX
           if (USBD_RTX_EPTask[num / 2]) {
             isr_evt_set(USBD_EVT_IN,  USBD_RTX_EPTask[num / 2]);
@@ -746,7 +890,6 @@ void USB_IRQHandler (void) {
           }
 #endif
         }
-        LPC_USB->INTSTAT = (1UL << num);
       }
     }
   }
@@ -50,13 +50,19 @@ typedef struct __EP{
   uint32_t   maxPacket;
 } EP;
 
+/* Linked dTDs for direct IN transfers                                        */
+#define DTD_CHAIN_NUM      4            /* dTDs per IN endpoint               */
+#define DTD_MAX_BYTES      0x4000       /* Bytes per dTD (5 buffer pages)     */
+
 EPQH __align(2048) EPQHx[(USBD_EP_NUM + 1) * 2];
 dTD  __align(32  ) dTDx[ (USBD_EP_NUM + 1) * 2];
+dTD  __align(32  ) dTDChain[USBD_EP_NUM + 1][DTD_CHAIN_NUM];
 
 EP        Ep[(USBD_EP_NUM + 1) * 2];
 uint32_t  BufUsed;
 
 uint32_t  IsoEp;
+uint32_t  DirectEp;                     /* IN endpoints using the dTD chain   */
 
 #define ENDPTCTRL(EPNum)  *(volatile uint32_t *)((uint32_t)(&LPC_USB0->ENDPTCTRL0) + 4 * EPNum)
 #define EP_OUT_IDX(EPNum)  (EPNum * 2    )
@@ -214,6 +220,11 @@ void USBD_Reset (void) {
   for (i = 0; i < sizeof(dTDx); i++) {
     ptr[i] = 0;
   }
+  DirectEp = 0;
+  ptr = (uint8_t *)dTDChain;
+  for (i = 0; i < sizeof(dTDChain); i++) {
+    ptr[i] = 0;
+  }
 
   LPC_USB0->ENDPTNAKEN         = 1;
 
@@ -516,6 +527,7 @@ void USBD_PrimeEp (uint32_t EPNum, uint32_t cnt) {
     EPNum &= 0x7F;
     idx    = EP_IN_IDX(EPNum);
     val    = (1UL << (EPNum + 16));
+    DirectEp &= ~val;
   }
   /* OUT endpoint                                                             */
   else {
@@ -622,6 +634,89 @@ uint32_t USBD_WriteEP (uint32_t EPNum, uint8_t *pData, uint32_t cnt) {
   return (cnt);
 }
 
+/*
+ *  Write USB Device Endpoint Data without copy (multi-packet transfer)
+ *   Data is sent directly from the buffer by a chain of linked dTDs and the
+ *   IN event is generated once the whole transfer is completed. The buffer
+ *   must stay valid until then. Zero length packet is not added.
+ *    Parameters:      EPNum: Endpoint Number
+ *                       EPNum.0..3: Address
+ *                       EPNum.7:    Dir
+ *                     pData: Pointer to Data Buffer
+ *                     cnt:   Number of bytes to write
+ *    Return Value:    Number of bytes written (0 = not possible)
+ */
+
+uint32_t USBD_WriteEPDirect (uint32_t EPNum, uint8_t *pData, uint32_t cnt) {
+  uint32_t addr, len, val, i, n;
+  dTD     *ptr;
+
+  EPNum &= 0x7f;
+  val    = (1UL << (EPNum + 16));
+
+  if ((cnt == 0) || (cnt > (DTD_CHAIN_NUM * DTD_MAX_BYTES)) || (IsoEp & val)) {
+    return (0);
+  }
+
+  /* Build dTD chain, interrupt on completion of last dTD only                */
+  ptr  = dTDChain[EPNum];
+  addr = (uint32_t)pData;
+  len  = cnt;
+  for (n = 0; len; n++) {
+    i = (len > DTD_MAX_BYTES) ? DTD_MAX_BYTES : len;
+    ptr[n].next_dTD  = (uint32_t)(&ptr[n + 1]);
+    ptr[n].dTD_token = (i << 16) |                 /* bytes to transfer       */
+                        0x80;                      /* status - active         */
+    ptr[n].buf[0]    = addr;
+    ptr[n].buf[1]    = (addr & ~0xFFF) + 0x1000;
+    ptr[n].buf[2]    = (addr & ~0xFFF) + 0x2000;
+    ptr[n].buf[3]    = (addr & ~0xFFF) + 0x3000;
+    ptr[n].buf[4]    = (addr & ~0xFFF) + 0x4000;
+    addr += i;
+    len  -= i;
+  }
+  ptr[n - 1].next_dTD   = 1;                       /* terminate chain         */
+  ptr[n - 1].dTD_token |= (1UL << 15);             /* int on complete         */
+
+  LPC_USB0->ENDPTCOMPLETE = val;
+  DirectEp |= val;
+
+  EPQHx[EP_IN_IDX(EPNum)].next_dTD   = (uint32_t)ptr;
+  EPQHx[EP_IN_IDX(EPNum)].dTD_token &= ~0xC0;
+
+  LPC_USB0->ENDPTPRIME = val;
+  while (LPC_USB0->ENDPTPRIME & val);
+
+  return (cnt);
+}
+
+/*
+ *  Get status of the last IN transfer of an endpoint
+ *   Direct transfers report the first dTD of the chain with an error (or
+ *   the last dTD), other transfers the endpoint dTD.
+ *    Parameters:      EPNum: Endpoint Number
+ *    Return Value:    dTD token status (active, halted, buffer and
+ *                     transaction error)
+ */
+
+static uint32_t USBD_InStatus (uint32_t EPNum) {
+  dTD     *ptr;
+  uint32_t n;
+
+  if (!(DirectEp & (1UL << (EPNum + 16)))) {
+    return (dTDx[EP_IN_IDX(EPNum)].dTD_token & 0xE8);
+  }
+
+  ptr = dTDChain[EPNum];
+  for (n = 1; n < DTD_CHAIN_NUM; n++) {
+    if ((ptr->dTD_token & 0x68) || (ptr->next_dTD & 1)) {
+      break;
+    }
+    ptr = (dTD *)ptr->next_dTD;
+  }
+  return (ptr->dTD_token & 0xE8);
+}
+
 /*
  *  Get USB Device Last Frame Number
  *    Parameters:      None
@@ -807,12 +902,12 @@ void USB0_IRQHandler (void) {
       if (cmpl & (1UL << (num + 16))) {
 #ifdef __RTX
         if (USBD_RTX_DevTask) {
-          LastError = dTDx[EP_IN_IDX(num)].dTD_token & 0xE8;
+          LastError = USBD_InStatus(num);
           isr_evt_set(USBD_EVT_ERROR, USBD_RTX_DevTask);
         }
 #else
         if (USBD_P_Error_Event) {
-          USBD_P_Error_Event(dTDx[EP_IN_IDX(num)].dTD_token & 0xE8);
+          USBD_P_Error_Event(USBD_InStatus(num));
         }
 #endif
       }
@@ -34,11 +34,23 @@ extern BOOL  usbd_configured            (void);
 /* USB Device user functions imported to USB HID Class module                 */
 extern void  usbd_hid_init              (void);
 extern BOOL  usbd_hid_get_report_trigger(U8 rid,   U8 *buf, int len);
+extern BOOL  usbd_hid_send_report       (U8 *buf, int len);
+extern int   usbd_hid_get_report_buf    (U8 **buf);
+extern U8   *usbd_hid_get_outreport_buf (void);
 extern int   usbd_hid_get_report        (U8 rtype, U8 rid, U8 *buf, U8  req);
 extern void  usbd_hid_set_report        (U8 rtype, U8 rid, U8 *buf, int len, U8 req);
 extern U8    usbd_hid_get_protocol      (void);
 extern void  usbd_hid_set_protocol      (U8 protocol);
 
+/* USB Device user functions imported to USB Bulk (WinUSB) module             */
+extern void  usbd_bulk_init             (void);
+extern BOOL  usbd_bulk_send             (U8 *buf, int len);
+extern int   usbd_bulk_get_inbuf        (U8 **buf);
+extern U8   *usbd_bulk_get_outbuf       (void);
+extern void  usbd_bulk_received         (U8 *buf, int len);
+extern int   usbd_bulk_swo_get_inbuf    (U8 **buf, int max);
+extern int   usbd_bulk_event_get_inbuf  (U8 **buf, int max);
+
 /* USB Device user functions imported to USB Mass Storage Class module        */
 extern void  usbd_msc_init              (void);
 extern void  usbd_msc_read_sect         (U32 block, U8 *buf, U32 num_of_blocks);
@@ -98,6 +98,19 @@ typedef __packed struct _USB_SETUP_PACKET {
 #define USB_OTG_DESCRIPTOR_TYPE                     9
 #define USB_DEBUG_DESCRIPTOR_TYPE                  10
 #define USB_INTERFACE_ASSOCIATION_DESCRIPTOR_TYPE  11
+#define USB_BOS_DESCRIPTOR_TYPE                    15
+#define USB_DEVICE_CAPABILITY_DESCRIPTOR_TYPE      16
+
+/* USB Device Capability Types */
+#define USB_DEVICE_CAPABILITY_PLATFORM         0x05
+
+/* Microsoft OS 2.0 Descriptors */
+#define MS_OS_20_DESCRIPTOR_INDEX              0x07
+#define MS_OS_20_SET_HEADER_DESCRIPTOR         0x00
+#define MS_OS_20_SUBSET_HEADER_CONFIGURATION   0x01
+#define MS_OS_20_SUBSET_HEADER_FUNCTION        0x02
+#define MS_OS_20_FEATURE_COMPATIBLE_ID         0x03
+#define MS_OS_20_FEATURE_REG_PROPERTY          0x04
 
 /* USB Device Classes */
 #define USB_DEVICE_CLASS_RESERVED              0x00
@@ -223,6 +236,14 @@ typedef __packed struct _USB_COMMON_DESCRIPTOR {
   U8  bDescriptorType;
 } USB_COMMON_DESCRIPTOR;
 
+/* USB Binary Device Object Store (BOS) Descriptor */
+typedef __packed struct _USB_BOS_DESCRIPTOR {
+  U8  bLength;
+  U8  bDescriptorType;
+  U16 wTotalLength;
+  U8  bNumDeviceCaps;
+} USB_BOS_DESCRIPTOR;
+
 /* USB Interface Association Descriptor */
 typedef __packed struct _USB_INTERFACE_ASSOCIATION_DESCRIPTOR {
   U8  bLength;
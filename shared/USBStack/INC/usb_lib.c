@@ -86,6 +86,16 @@ const   U8  *usbd_msc_inquiry_data      =  USBD_MSC_INQUIRY_DATA;
         U8   USBD_MSC_BulkBuf             [USBD_MSC_MAX_PACKET*USBD_MSC_ENABLE];
 #endif
 
+#if    (USBD_BULK_ENABLE)
+const   U8   usbd_bulk_if_num           =  USBD_BULK_IF_NUM;
+const   U8   usbd_bulk_ep_bulkin        =  USBD_BULK_EP_BULKIN;
+const   U8   usbd_bulk_ep_bulkout       =  USBD_BULK_EP_BULKOUT;
+const   U8   usbd_bulk_ep_swoin         =  USBD_BULK_EP_SWOIN;
+const   U8   usbd_bulk_ep_eventin       =  USBD_BULK_EP_EVENTIN;
+const   U16  usbd_bulk_maxpacketsize[2] = {USBD_BULK_WMAXPACKETSIZE, USBD_BULK_HS_WMAXPACKETSIZE};
+const   U16  usbd_bulk_max_transfer     =  USBD_BULK_MAX_TRANSFER;
+#endif
+
 #if    (USBD_ADC_ENABLE)
 const   U8   usbd_adc_cif_num           =  USBD_ADC_CIF_NUM;
 const   U8   usbd_adc_sif1_num          =  USBD_ADC_SIF1_NUM;
@@ -125,10 +135,20 @@ const   U16  usbd_cdc_acm_maxpacketsize1[2] = {USBD_CDC_ACM_WMAXPACKETSIZE1, USB
  *      USB Device Override Event Handler Fuctions
  *----------------------------------------------------------------------------*/
 
-#if    (USBD_HID_ENABLE)
+#if   ((USBD_HID_ENABLE) || (USBD_BULK_ENABLE))
   #ifndef __RTX
-                                           void USBD_Configure_Event (void)             { USBD_HID_Configure_Event (); }
+  void USBD_Configure_Event (void) {
+    #if    (USBD_HID_ENABLE)
+    USBD_HID_Configure_Event  ();
+    #endif
+    #if    (USBD_BULK_ENABLE)
+    USBD_BULK_Configure_Event ();
+    #endif
+  }
   #endif
+#endif
+
+#if    (USBD_HID_ENABLE)
   #ifdef __RTX
     #if   ((USBD_HID_EP_INTOUT != 0) && (USBD_HID_EP_INTIN != USBD_HID_EP_INTOUT))
       #if    (USBD_HID_EP_INTIN == 1)
@@ -600,6 +620,171 @@ const   U16  usbd_cdc_acm_maxpacketsize1[2] = {USBD_CDC_ACM_WMAXPACKETSIZE1, USB
   BOOL USBD_EndPoint0_Out_MSC_ReqToIF     (void)                                        { return (__FALSE); }
 #endif  /* (USBD_MSC_ENABLE) */
 
+#if    (USBD_BULK_ENABLE)
+  #ifdef __RTX
+    #error "Bulk DAP Interface is not supported with RTX"
+  #else
+    #if    (USBD_BULK_EP_BULKIN != USBD_BULK_EP_BULKOUT)
+      #if    (USBD_BULK_EP_BULKIN == 1)
+        #define USBD_EndPoint1                 USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 2)
+        #define USBD_EndPoint2                 USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 3)
+        #define USBD_EndPoint3                 USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 4)
+        #define USBD_EndPoint4                 USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 5)
+        #define USBD_EndPoint5                 USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 6)
+        #define USBD_EndPoint6                 USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 7)
+        #define USBD_EndPoint7                 USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 8)
+        #define USBD_EndPoint8                 USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 9)
+        #define USBD_EndPoint9                 USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 10)
+        #define USBD_EndPoint10                USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 11)
+        #define USBD_EndPoint11                USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 12)
+        #define USBD_EndPoint12                USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 13)
+        #define USBD_EndPoint13                USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 14)
+        #define USBD_EndPoint14                USBD_BULK_EP_BULKIN_Event
+      #elif  (USBD_BULK_EP_BULKIN == 15)
+        #define USBD_EndPoint15                USBD_BULK_EP_BULKIN_Event
+      #endif
+      #if    (USBD_BULK_EP_BULKOUT == 1)
+        #define USBD_EndPoint1                 USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 2)
+        #define USBD_EndPoint2                 USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 3)
+        #define USBD_EndPoint3                 USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 4)
+        #define USBD_EndPoint4                 USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 5)
+        #define USBD_EndPoint5                 USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 6)
+        #define USBD_EndPoint6                 USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 7)
+        #define USBD_EndPoint7                 USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 8)
+        #define USBD_EndPoint8                 USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 9)
+        #define USBD_EndPoint9                 USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 10)
+        #define USBD_EndPoint10                USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 11)
+        #define USBD_EndPoint11                USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 12)
+        #define USBD_EndPoint12                USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 13)
+        #define USBD_EndPoint13                USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 14)
+        #define USBD_EndPoint14                USBD_BULK_EP_BULKOUT_Event
+      #elif  (USBD_BULK_EP_BULKOUT == 15)
+        #define USBD_EndPoint15                USBD_BULK_EP_BULKOUT_Event
+      #endif
+    #else
+      #if    (USBD_BULK_EP_BULKIN == 1)
+        #define USBD_EndPoint1                 USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 2)
+        #define USBD_EndPoint2                 USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 3)
+        #define USBD_EndPoint3                 USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 4)
+        #define USBD_EndPoint4                 USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 5)
+        #define USBD_EndPoint5                 USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 6)
+        #define USBD_EndPoint6                 USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 7)
+        #define USBD_EndPoint7                 USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 8)
+        #define USBD_EndPoint8                 USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 9)
+        #define USBD_EndPoint9                 USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 10)
+        #define USBD_EndPoint10                USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 11)
+        #define USBD_EndPoint11                USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 12)
+        #define USBD_EndPoint12                USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 13)
+        #define USBD_EndPoint13                USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 14)
+        #define USBD_EndPoint14                USBD_BULK_EP_BULK_Event
+      #elif  (USBD_BULK_EP_BULKIN == 15)
+        #define USBD_EndPoint15                USBD_BULK_EP_BULK_Event
+      #endif
+    #endif
+    #if    (USBD_BULK_EP_SWOIN == 1)
+      #define USBD_EndPoint1                 USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 2)
+      #define USBD_EndPoint2                 USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 3)
+      #define USBD_EndPoint3                 USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 4)
+      #define USBD_EndPoint4                 USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 5)
+      #define USBD_EndPoint5                 USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 6)
+      #define USBD_EndPoint6                 USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 7)
+      #define USBD_EndPoint7                 USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 8)
+      #define USBD_EndPoint8                 USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 9)
+      #define USBD_EndPoint9                 USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 10)
+      #define USBD_EndPoint10                USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 11)
+      #define USBD_EndPoint11                USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 12)
+      #define USBD_EndPoint12                USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 13)
+      #define USBD_EndPoint13                USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 14)
+      #define USBD_EndPoint14                USBD_BULK_EP_SWOIN_Event
+    #elif  (USBD_BULK_EP_SWOIN == 15)
+      #define USBD_EndPoint15                USBD_BULK_EP_SWOIN_Event
+    #endif
+    #if    (USBD_BULK_EP_EVENTIN == 1)
+      #define USBD_EndPoint1                 USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 2)
+      #define USBD_EndPoint2                 USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 3)
+      #define USBD_EndPoint3                 USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 4)
+      #define USBD_EndPoint4                 USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 5)
+      #define USBD_EndPoint5                 USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 6)
+      #define USBD_EndPoint6                 USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 7)
+      #define USBD_EndPoint7                 USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 8)
+      #define USBD_EndPoint8                 USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 9)
+      #define USBD_EndPoint9                 USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 10)
+      #define USBD_EndPoint10                USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 11)
+      #define USBD_EndPoint11                USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 12)
+      #define USBD_EndPoint12                USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 13)
+      #define USBD_EndPoint13                USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 14)
+      #define USBD_EndPoint14                USBD_BULK_EP_EVENTIN_Event
+    #elif  (USBD_BULK_EP_EVENTIN == 15)
+      #define USBD_EndPoint15                USBD_BULK_EP_EVENTIN_Event
+    #endif
+  #endif
+#endif  /* (USBD_BULK_ENABLE) */
+
 #if    (USBD_ADC_ENABLE == 0)
   BOOL USBD_EndPoint0_Setup_ADC_ReqToIF   (void)                                        { return (__FALSE); }
   BOOL USBD_EndPoint0_Setup_ADC_ReqToEP   (void)                                        { return (__FALSE); }
@@ -896,12 +1081,15 @@ const   U16  usbd_cdc_acm_maxpacketsize1[2] = {USBD_CDC_ACM_WMAXPACKETSIZE1, USB
   #endif
 #endif  /* ((USBD_CDC_ACM_ENABLE)) */
 
-#if   ((USBD_HID_ENABLE) || (USBD_ADC_ENABLE) || (USBD_CDC_ACM_ENABLE) || (USBD_CLS_ENABLE))
+#if   ((USBD_HID_ENABLE) || (USBD_ADC_ENABLE) || (USBD_CDC_ACM_ENABLE) || (USBD_CLS_ENABLE) || (USBD_BULK_ENABLE))
   #ifndef __RTX
   void USBD_SOF_Event (void) {
     #if    (USBD_HID_ENABLE)
     USBD_HID_SOF_Event     ();
     #endif
+    #if    (USBD_BULK_ENABLE)
+    USBD_BULK_SOF_Event    ();
+    #endif
     #if    (USBD_ADC_ENABLE)
     USBD_ADC_SOF_Event     ();
     #endif
@@ -913,7 +1101,7 @@ const   U16  usbd_cdc_acm_maxpacketsize1[2] = {USBD_CDC_ACM_WMAXPACKETSIZE1, USB
     #endif
   }
   #endif
-#endif  /* ((USBD_HID_ENABLE) || (USBD_ADC_ENABLE) || (USBD_CDC_ACM_ENABLE) || (USBD_CLS_ENABLE)) */
+#endif  /* ((USBD_HID_ENABLE) || (USBD_ADC_ENABLE) || (USBD_CDC_ACM_ENABLE) || (USBD_CLS_ENABLE) || (USBD_BULK_ENABLE)) */
 
 /* USB Device - Device Events Callback Functions */
 __weak   void USBD_Power_Event       (BOOL power);
@@ -1014,7 +1202,7 @@ void (* const USBD_P_Feature_Event  )(void)       = USBD_Feature_Event;
 #ifdef __RTX
 const BOOL __rtx = __TRUE;
 
-#if   ((USBD_HID_ENABLE) || (USBD_ADC_ENABLE) || (USBD_CDC_ACM_ENABLE) || (USBD_CLS_ENABLE))
+#if   ((USBD_HID_ENABLE) || (USBD_ADC_ENABLE) || (USBD_CDC_ACM_ENABLE) || (USBD_CLS_ENABLE) || (USBD_BULK_ENABLE))
 __weak __task void USBD_RTX_Device     (void)   {
   U16 evt;
 
@@ -1032,6 +1220,9 @@ __weak __task void USBD_RTX_Device     (void)   {
 #if (USBD_HID_ENABLE)
       USBD_HID_SOF_Event     ();
 #endif
+#if (USBD_BULK_ENABLE)
+      USBD_BULK_SOF_Event    ();
+#endif
 #if (USBD_ADC_ENABLE)
       USBD_ADC_SOF_Event     ();
 #endif
@@ -1158,6 +1349,9 @@ void usbd_class_init     (void)                                       {
 #if (USBD_MSC_ENABLE)
                                                                         usbd_msc_init();
 #endif
+#if (USBD_BULK_ENABLE)
+                                                                        usbd_bulk_init();
+#endif
 #if (USBD_ADC_ENABLE)
                                                                         usbd_adc_init();
 #endif
@@ -1203,13 +1397,15 @@ void USBD_RTX_TaskInit (void) {
 #define USBD_HID_DESC_LEN                 (USB_INTERFACE_DESC_SIZE + USB_HID_DESC_SIZE                                                          + \
                                           (USB_ENDPOINT_DESC_SIZE*(1+(USBD_HID_EP_INTOUT != 0))))
 #define USBD_MSC_DESC_LEN                 (USB_INTERFACE_DESC_SIZE + 2*USB_ENDPOINT_DESC_SIZE)
+#define USBD_BULK_DESC_LEN                (USB_INTERFACE_DESC_SIZE + USB_ENDPOINT_DESC_SIZE*(2+(USBD_BULK_EP_SWOIN != 0)+(USBD_BULK_EP_EVENTIN != 0)))
 #define USBD_HID_DESC_OFS                 (USB_CONFIGUARTION_DESC_SIZE + USB_INTERFACE_DESC_SIZE                                                + \
                                            USBD_CDC_ACM_ENABLE * USBD_CDC_ACM_DESC_LEN)
 
 #define USBD_WTOTALLENGTH                 (USB_CONFIGUARTION_DESC_SIZE +                 \
                                            USBD_CDC_ACM_DESC_LEN * USBD_CDC_ACM_ENABLE + \
                                            USBD_HID_DESC_LEN     * USBD_HID_ENABLE     + \
-                                           USBD_MSC_DESC_LEN     * USBD_MSC_ENABLE)
+                                           USBD_MSC_DESC_LEN     * USBD_MSC_ENABLE     + \
+                                           USBD_BULK_DESC_LEN    * USBD_BULK_ENABLE)
 
 /*------------------------------------------------------------------------------
   Default HID Report Descriptor
@@ -1269,7 +1465,9 @@ __weak \
 const U8 USBD_DeviceDescriptor[] = {
   USB_DEVICE_DESC_SIZE,                 /* bLength */
   USB_DEVICE_DESCRIPTOR_TYPE,           /* bDescriptorType */
-#if ((USBD_HS_ENABLE) || (USBD_MULTI_IF))
+#if (USBD_BULK_ENABLE)
+  WBVAL(0x0210), /* 2.10 */             /* bcdUSB: BOS descriptor supported */
+#elif ((USBD_HS_ENABLE) || (USBD_MULTI_IF))
   WBVAL(0x0110), /* 2.00 */             /* bcdUSB */
 #else
   WBVAL(0x0110), /* 1.10 */             /* bcdUSB */
@@ -1454,6 +1652,98 @@ const U8 USBD_DeviceQualifier_HS[] = { 0 };
   WBVAL(USBD_MSC_HS_WMAXPACKETSIZE),    /* wMaxPacketSize */                                                \
   USBD_MSC_HS_BINTERVAL,                /* bInterval */
 
+#define BULK_DESC                                                                                           \
+/* Interface, Alternate Setting 0, Vendor Class (bulk DAP) */                                               \
+  USB_INTERFACE_DESC_SIZE,              /* bLength */                                                       \
+  USB_INTERFACE_DESCRIPTOR_TYPE,        /* bDescriptorType */                                               \
+  USBD_BULK_IF_NUM,                     /* bInterfaceNumber */                                              \
+  0x00,                                 /* bAlternateSetting */                                             \
+  0x02+(USBD_BULK_EP_SWOIN != 0)+(USBD_BULK_EP_EVENTIN != 0), /* bNumEndpoints */                           \
+  USB_DEVICE_CLASS_VENDOR_SPECIFIC,     /* bInterfaceClass */                                               \
+  0x00,                                 /* bInterfaceSubClass */                                            \
+  0x00,                                 /* bInterfaceProtocol */                                            \
+  USBD_BULK_IF_STR_NUM,                 /* iInterface */
+
+#define BULK_EP                         /* Bulk DAP Endpoints for Full-speed */                             \
+/* Endpoint, EP Bulk OUT */                                                                                 \
+  USB_ENDPOINT_DESC_SIZE,               /* bLength */                                                       \
+  USB_ENDPOINT_DESCRIPTOR_TYPE,         /* bDescriptorType */                                               \
+  USB_ENDPOINT_OUT(USBD_BULK_EP_BULKOUT),/* bEndpointAddress */                                             \
+  USB_ENDPOINT_TYPE_BULK,               /* bmAttributes */                                                  \
+  WBVAL(USBD_BULK_WMAXPACKETSIZE),      /* wMaxPacketSize */                                                \
+  0x00,                                 /* bInterval: ignore for Bulk transfer */                           \
+                                                                                                            \
+/* Endpoint, EP Bulk IN */                                                                                  \
+  USB_ENDPOINT_DESC_SIZE,               /* bLength */                                                       \
+  USB_ENDPOINT_DESCRIPTOR_TYPE,         /* bDescriptorType */                                               \
+  USB_ENDPOINT_IN(USBD_BULK_EP_BULKIN), /* bEndpointAddress */                                              \
+  USB_ENDPOINT_TYPE_BULK,               /* bmAttributes */                                                  \
+  WBVAL(USBD_BULK_WMAXPACKETSIZE),      /* wMaxPacketSize */                                                \
+  0x00,                                 /* bInterval: ignore for Bulk transfer */
+
+#define BULK_EP_HS                      /* Bulk DAP Endpoints for High-speed */                             \
+/* Endpoint, EP Bulk OUT */                                                                                 \
+  USB_ENDPOINT_DESC_SIZE,               /* bLength */                                                       \
+  USB_ENDPOINT_DESCRIPTOR_TYPE,         /* bDescriptorType */                                               \
+  USB_ENDPOINT_OUT(USBD_BULK_EP_BULKOUT),/* bEndpointAddress */                                             \
+  USB_ENDPOINT_TYPE_BULK,               /* bmAttributes */                                                  \
+  WBVAL(USBD_BULK_HS_WMAXPACKETSIZE),   /* wMaxPacketSize */                                                \
+  USBD_BULK_HS_BINTERVAL,               /* bInterval */                                                     \
+                                                                                                            \
+/* Endpoint, EP Bulk IN */                                                                                  \
+  USB_ENDPOINT_DESC_SIZE,               /* bLength */                                                       \
+  USB_ENDPOINT_DESCRIPTOR_TYPE,         /* bDescriptorType */                                               \
+  USB_ENDPOINT_IN(USBD_BULK_EP_BULKIN), /* bEndpointAddress */                                              \
+  USB_ENDPOINT_TYPE_BULK,               /* bmAttributes */                                                  \
+  WBVAL(USBD_BULK_HS_WMAXPACKETSIZE),   /* wMaxPacketSize */                                                \
+  USBD_BULK_HS_BINTERVAL,               /* bInterval */
+
+#if (USBD_BULK_EP_SWOIN != 0)
+#define BULK_EP_SWO                     /* Bulk SWO Trace Endpoint for Full-speed */                        \
+/* Endpoint, EP Bulk IN (SWO Trace) */                                                                      \
+  USB_ENDPOINT_DESC_SIZE,               /* bLength */                                                       \
+  USB_ENDPOINT_DESCRIPTOR_TYPE,         /* bDescriptorType */                                               \
+  USB_ENDPOINT_IN(USBD_BULK_EP_SWOIN),  /* bEndpointAddress */                                              \
+  USB_ENDPOINT_TYPE_BULK,               /* bmAttributes */                                                  \
+  WBVAL(USBD_BULK_WMAXPACKETSIZE),      /* wMaxPacketSize */                                                \
+  0x00,                                 /* bInterval: ignore for Bulk transfer */
+
+#define BULK_EP_SWO_HS                  /* Bulk SWO Trace Endpoint for High-speed */                        \
+/* Endpoint, EP Bulk IN (SWO Trace) */                                                                      \
+  USB_ENDPOINT_DESC_SIZE,               /* bLength */                                                       \
+  USB_ENDPOINT_DESCRIPTOR_TYPE,         /* bDescriptorType */                                               \
+  USB_ENDPOINT_IN(USBD_BULK_EP_SWOIN),  /* bEndpointAddress */                                              \
+  USB_ENDPOINT_TYPE_BULK,               /* bmAttributes */                                                  \
+  WBVAL(USBD_BULK_HS_WMAXPACKETSIZE),   /* wMaxPacketSize */                                                \
+  USBD_BULK_HS_BINTERVAL,               /* bInterval */
+#else
+#define BULK_EP_SWO
+#define BULK_EP_SWO_HS
+#endif
+
+#if (USBD_BULK_EP_EVENTIN != 0)
+#define BULK_EP_EVENT                   /* Bulk Event Endpoint for Full-speed */                            \
+/* Endpoint, EP Interrupt IN (Events) */                                                                    \
+  USB_ENDPOINT_DESC_SIZE,               /* bLength */                                                       \
+  USB_ENDPOINT_DESCRIPTOR_TYPE,         /* bDescriptorType */                                               \
+  USB_ENDPOINT_IN(USBD_BULK_EP_EVENTIN),/* bEndpointAddress */                                              \
+  USB_ENDPOINT_TYPE_INTERRUPT,          /* bmAttributes */                                                  \
+  WBVAL(USBD_BULK_WMAXPACKETSIZE),      /* wMaxPacketSize */                                                \
+  USBD_BULK_EVENT_BINTERVAL,            /* bInterval */
+
+#define BULK_EP_EVENT_HS                /* Bulk Event Endpoint for High-speed */                            \
+/* Endpoint, EP Interrupt IN (Events) */                                                                    \
+  USB_ENDPOINT_DESC_SIZE,               /* bLength */                                                       \
+  USB_ENDPOINT_DESCRIPTOR_TYPE,         /* bDescriptorType */                                               \
+  USB_ENDPOINT_IN(USBD_BULK_EP_EVENTIN),/* bEndpointAddress */                                              \
+  USB_ENDPOINT_TYPE_INTERRUPT,          /* bmAttributes */                                                  \
+  WBVAL(USBD_BULK_WMAXPACKETSIZE),      /* wMaxPacketSize */                                                \
+  USBD_BULK_EVENT_HS_BINTERVAL,         /* bInterval */
+#else
+#define BULK_EP_EVENT
+#define BULK_EP_EVENT_HS
+#endif
+
 #define ADC_DESC_IAD(first,num_of_ifs)  /* ADC: Interface Association Descriptor */                         \
   USB_INTERFACE_ASSOC_DESC_SIZE,        /* bLength */                                                       \
   USB_INTERFACE_ASSOCIATION_DESCRIPTOR_TYPE,  /* bDescriptorType */                                         \
@@ -1758,6 +2048,12 @@ const U8 USBD_ConfigDescriptor[] = {
 #endif
 #endif
 
+#if (USBD_BULK_ENABLE)
+  BULK_DESC
+  BULK_EP
+  BULK_EP_SWO
+  BULK_EP_EVENT
+#endif
 
 /* Terminator */                                                                                            \
   0                                     /* bLength */                                                       \
@@ -1819,6 +2115,13 @@ const U8 USBD_ConfigDescriptor_HS[] = {
   MSC_EP_HS
 #endif
 
+#if (USBD_BULK_ENABLE)
+  BULK_DESC
+  BULK_EP_HS
+  BULK_EP_SWO_HS
+  BULK_EP_EVENT_HS
+#endif
+
 /* Terminator */                                                                                            \
   0                                     /* bLength */                                                       \
 };
@@ -1870,6 +2173,13 @@ const U8 USBD_OtherSpeedConfigDescriptor[] = {
   MSC_EP_HS
 #endif
 
+#if (USBD_BULK_ENABLE)
+  BULK_DESC
+  BULK_EP_HS
+  BULK_EP_SWO_HS
+  BULK_EP_EVENT_HS
+#endif
+
 /* Terminator */
   0                                     /* bLength */
 };
@@ -1921,6 +2231,13 @@ const U8 USBD_OtherSpeedConfigDescriptor_HS[] = {
   MSC_EP
 #endif
 
+#if (USBD_BULK_ENABLE)
+  BULK_DESC
+  BULK_EP
+  BULK_EP_SWO
+  BULK_EP_EVENT
+#endif
+
 /* Terminator */
   0                                     /* bLength */
 };
@@ -1964,6 +2281,9 @@ const struct {
 #if (USBD_MSC_ENABLE)
   USBD_STR_DEF(MSC_STRDESC);
 #endif
+#if (USBD_BULK_ENABLE)
+  USBD_STR_DEF(BULK_STRDESC);
+#endif
 } USBD_StringDescriptor
   =
 {
@@ -1988,8 +2308,107 @@ const struct {
 #if (USBD_MSC_ENABLE)
   USBD_STR_VAL(MSC_STRDESC),
 #endif
+#if (USBD_BULK_ENABLE)
+  USBD_STR_VAL(BULK_STRDESC),
+#endif
 };
 
+#if (USBD_BULK_ENABLE)
+const U8 usbd_msos20_vendor_code = USBD_BULK_VENDOR_CODE;
+
+/* Microsoft OS 2.0 Descriptor Set lengths */
+#define USBD_MSOS20_FEATURE_LEN           (20 + 10 + 42 + 80)
+#define USBD_MSOS20_FUNCTION_LEN          (8 + USBD_MSOS20_FEATURE_LEN)
+#define USBD_MSOS20_CONFIG_LEN            (8 + USBD_MSOS20_FUNCTION_LEN)
+#define USBD_MSOS20_DESC_LEN              (10 + USBD_MSOS20_CONFIG_LEN)
+
+/* USB Device Binary Object Store Descriptor */
+/*   Announces the Microsoft OS 2.0 descriptor set and its vendor request */
+__weak \
+const U8 USBD_BOSDescriptor[] = {
+  USB_BOS_DESC_SIZE,                    /* bLength */
+  USB_BOS_DESCRIPTOR_TYPE,              /* bDescriptorType */
+  WBVAL(USB_BOS_DESC_SIZE + 28),        /* wTotalLength */
+  0x01,                                 /* bNumDeviceCaps */
+
+/* Microsoft OS 2.0 Platform Capability Descriptor */
+  28,                                   /* bLength */
+  USB_DEVICE_CAPABILITY_DESCRIPTOR_TYPE,/* bDescriptorType */
+  USB_DEVICE_CAPABILITY_PLATFORM,       /* bDevCapabilityType */
+  0x00,                                 /* bReserved */
+  0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C,
+  0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F,
+                                        /* PlatformCapabilityUUID */
+  0x00, 0x00, 0x03, 0x06,               /* dwWindowsVersion: Windows 8.1 */
+  WBVAL(USBD_MSOS20_DESC_LEN),          /* wMSOSDescriptorSetTotalLength */
+  USBD_BULK_VENDOR_CODE,                /* bMS_VendorCode */
+  0x00                                  /* bAltEnumCode */
+};
+
+/* Microsoft OS 2.0 Descriptor Set */
+/*   Binds the bulk DAP interface to the WinUSB driver */
+__weak \
+const U8 USBD_MSOS20Descriptor[] = {
+/* Descriptor Set Header */
+  WBVAL(10),                            /* wLength */
+  WBVAL(MS_OS_20_SET_HEADER_DESCRIPTOR),/* wDescriptorType */
+  0x00, 0x00, 0x03, 0x06,               /* dwWindowsVersion: Windows 8.1 */
+  WBVAL(USBD_MSOS20_DESC_LEN),          /* wTotalLength */
+
+/* Configuration Subset Header */
+  WBVAL(8),                             /* wLength */
+  WBVAL(MS_OS_20_SUBSET_HEADER_CONFIGURATION), /* wDescriptorType */
+  0x00,                                 /* bConfigurationValue: configuration index */
+  0x00,                                 /* bReserved */
+  WBVAL(USBD_MSOS20_CONFIG_LEN),        /* wTotalLength */
+
+/* Function Subset Header */
+  WBVAL(8),                             /* wLength */
+  WBVAL(MS_OS_20_SUBSET_HEADER_FUNCTION), /* wDescriptorType */
+  USBD_BULK_IF_NUM,                     /* bFirstInterface */
+  0x00,                                 /* bReserved */
+  WBVAL(USBD_MSOS20_FUNCTION_LEN),      /* wSubsetLength */
+
+/* Compatible ID Descriptor */
+  WBVAL(20),                            /* wLength */
+  WBVAL(MS_OS_20_FEATURE_COMPATIBLE_ID),/* wDescriptorType */
+  'W', 'I', 'N', 'U', 'S', 'B', 0, 0,   /* CompatibleID */
+  0, 0, 0, 0, 0, 0, 0, 0,               /* SubCompatibleID */
+
+/* Registry Property Descriptor */
+  WBVAL(10 + 42 + 80),                  /* wLength */
+  WBVAL(MS_OS_20_FEATURE_REG_PROPERTY), /* wDescriptorType */
+  WBVAL(7),                             /* wPropertyDataType: REG_MULTI_SZ */
+  WBVAL(42),                            /* wPropertyNameLength */
+  'D', 0, 'e', 0, 'v', 0, 'i', 0,
+  'c', 0, 'e', 0, 'I', 0, 'n', 0,
+  't', 0, 'e', 0, 'r', 0, 'f', 0,
+  'a', 0, 'c', 0, 'e', 0, 'G', 0,
+  'U', 0, 'I', 0, 'D', 0, 's', 0,
+  0, 0,
+                                        /* PropertyName: "DeviceInterfaceGUIDs" */
+  WBVAL(80),                            /* wPropertyDataLength */
+  '{', 0, 'C', 0, 'D', 0, 'B', 0,
+  '3', 0, 'B', 0, '5', 0, 'A', 0,
+  'D', 0, '-', 0, '2', 0, '9', 0,
+  '3', 0, 'B', 0, '-', 0, '4', 0,
+  '6', 0, '6', 0, '3', 0, '-', 0,
+  'A', 0, 'A', 0, '3', 0, '6', 0,
+  '-', 0, '1', 0, 'A', 0, 'A', 0,
+  'E', 0, '4', 0, '6', 0, '4', 0,
+  '6', 0, '3', 0, '7', 0, '7', 0,
+  '6', 0, '}', 0, 0, 0, 0, 0
+                                        /* PropertyData: CMSIS-DAP v2 interface GUID */
+};
+#else
+const U8 usbd_msos20_vendor_code = 0;
+
+__weak \
+const U8 USBD_BOSDescriptor[] = { 0 };
+__weak \
+const U8 USBD_MSOS20Descriptor[] = { 0 };
+#endif
+
 #endif
 
 #endif  /* __USB_CONFIG__ */
@@ -59,6 +59,14 @@ extern const U16  usbd_msc_maxpacketsize[2];
 extern const U8  *usbd_msc_inquiry_data;
 extern       U8   USBD_MSC_BulkBuf      [];
 
+extern const U8   usbd_bulk_if_num;
+extern const U8   usbd_bulk_ep_bulkin;
+extern const U8   usbd_bulk_ep_bulkout;
+extern const U8   usbd_bulk_ep_swoin;
+extern const U8   usbd_bulk_ep_eventin;
+extern const U16  usbd_bulk_maxpacketsize[2];
+extern const U16  usbd_bulk_max_transfer;
+
 extern const U8   usbd_adc_enable;
 extern const U8   usbd_adc_cif_num;
 extern const U8   usbd_adc_sif1_num;
@@ -108,5 +116,8 @@ extern const U8   USBD_OtherSpeedConfigDescriptor_HS[];
 extern const U8   USBD_OtherSpeedConfigDescriptor[];
 extern const U8   USBD_OtherSpeedConfigDescriptor_HS[];
 extern const U8   USBD_StringDescriptor[];
+extern const U8   USBD_BOSDescriptor[];
+extern const U8   USBD_MSOS20Descriptor[];
+extern const U8   usbd_msos20_vendor_code;
 
 #endif  /* __USB_LIB_H__ */
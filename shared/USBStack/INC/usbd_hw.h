@@ -37,6 +37,7 @@ extern void USBD_ClrStallEP  (U32  EPNum);
 extern void USBD_ClearEPBuf  (U32  EPNum);
 extern U32  USBD_ReadEP      (U32  EPNum, U8 *pData);
 extern U32  USBD_WriteEP     (U32  EPNum, U8 *pData, U32 cnt);
+extern U32  USBD_WriteEPDirect (U32  EPNum, U8 *pData, U32 cnt);
 extern U32  USBD_GetFrame    (void);
 extern U32  USBD_GetError    (void);
 
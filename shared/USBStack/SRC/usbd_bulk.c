@@ -0,0 +1,287 @@
+/* CMSIS-DAP Interface Firmware
+ * Copyright (c) 2009-2013 ARM Limited
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <RTL.h>
+#include <rl_usb.h>
+#include <string.h>
+#include "usb_for_lib.h"
+
+
+static U8           *BulkInPtr;         /* Data being sent                    */
+static U16           BulkInLen;         /* Bytes left to send                 */
+static BOOL          BulkInZLP;         /* Zero length packet ends transfer   */
+static volatile BOOL BulkInActive;      /* Transfer to host in progress       */
+
+static U8           *BulkOutPtr;        /* Buffer for data being received     */
+static U16           BulkOutLen;        /* Bytes received in transfer         */
+static U8            BulkOutPending;    /* Packets left in endpoint (NAK)     */
+
+static volatile BOOL BulkSwoActive;     /* Trace packet to host in progress   */
+static BOOL          BulkSwoZLP;        /* Zero length packet ends trace data */
+
+static volatile BOOL BulkEventActive;   /* Event packet to host in progress   */
+
+
+/* Dummy Weak Functions that need to be provided by user */
+__weak void  usbd_bulk_init        (void)                                        {};
+__weak int   usbd_bulk_get_inbuf   (U8 **buf)                                    { return (0); };
+__weak U8   *usbd_bulk_get_outbuf  (void)                                        { return (NULL); };
+__weak void  usbd_bulk_received    (U8 *buf, int len)                            {};
+__weak int   usbd_bulk_swo_get_inbuf (U8 **buf, int max)                         { return (0); };
+__weak int   usbd_bulk_event_get_inbuf (U8 **buf, int max)                       { return (0); };
+
+
+/*
+ *  USB Device Bulk Start Transfer to host
+ *   Transfers shorter than the maximum transfer size which end on a packet
+ *   boundary are terminated with a zero length packet. Multi-packet transfers
+ *   are handed to the hardware at once when it supports it.
+ *    Parameters:      buf: Pointer to data buffer
+ *                     len: Number of bytes to be sent
+ *    Return Value:    None
+ */
+
+static void USBD_BULK_StartIn (U8 *buf, U16 len) {
+  U16 mps;
+
+  mps = usbd_bulk_maxpacketsize[USBD_HighSpeed];
+  BulkInPtr    = buf;
+  BulkInLen    = len;
+  BulkInZLP    = ((len % mps) == 0) && (len < usbd_bulk_max_transfer);
+  BulkInActive = __TRUE;
+  if ((len > mps) && USBD_WriteEPDirect(usbd_bulk_ep_bulkin | 0x80, buf, len)) {
+    BulkInPtr += len;
+    BulkInLen  = 0;
+    return;
+  }
+  USBD_BULK_EP_BULKIN_Event (0);
+}
+
+
+/*
+ *  USB Device Bulk In Endpoint Event Callback
+ *   Sends next packet of transfer in progress or starts next transfer
+ *    Parameters:      event: not used (just for compatibility)
+ *    Return Value:    None
+ */
+
+void USBD_BULK_EP_BULKIN_Event (U32 event) {
+  U16 bytes_to_send;
+  U8 *buf;
+  int len;
+
+  if (!BulkInLen && !BulkInZLP) {       /* If transfer is finished            */
+    if (!BulkInActive) return;
+    BulkInActive = __FALSE;
+    len = usbd_bulk_get_inbuf (&buf);   /* Release buffer, get next one       */
+    if (len) {
+      USBD_BULK_StartIn (buf, len);
+    }
+    return;
+  }
+
+  bytes_to_send = BulkInLen;
+  if (bytes_to_send > usbd_bulk_maxpacketsize[USBD_HighSpeed])
+    bytes_to_send = usbd_bulk_maxpacketsize[USBD_HighSpeed];
+  if (!bytes_to_send)                   /* If zero length packet is sent      */
+    BulkInZLP = __FALSE;
+  USBD_WriteEP(usbd_bulk_ep_bulkin | 0x80, BulkInPtr, bytes_to_send);
+  BulkInPtr += bytes_to_send;
+  BulkInLen -= bytes_to_send;
+}
+
+
+/*
+ *  USB Device Bulk Out Endpoint Event Callback
+ *   Receives transfer into user buffer; transfer ends with a short packet or
+ *   when the maximum transfer size is reached
+ *    Parameters:      event: not used (just for compatibility)
+ *    Return Value:    None
+ */
+
+void USBD_BULK_EP_BULKOUT_Event (U32 event) {
+  U16 bytes_rece;
+
+  if (!BulkOutLen) {                    /* Check if new reception             */
+    BulkOutPtr     = usbd_bulk_get_outbuf ();
+    if (BulkOutPtr == NULL) {           /* If no buffer leave packet in       */
+      BulkOutPending++;                 /* endpoint (NAK) and receive it from */
+      return;                           /* SOF when buffer is available       */
+    }
+  }
+  bytes_rece       = USBD_ReadEP(usbd_bulk_ep_bulkout, BulkOutPtr + BulkOutLen);
+  BulkOutLen      += bytes_rece;
+  if ((BulkOutLen >= usbd_bulk_max_transfer) ||
+      (bytes_rece <  usbd_bulk_maxpacketsize[USBD_HighSpeed])) {
+    usbd_bulk_received (BulkOutPtr, BulkOutLen);
+    BulkOutLen = 0;
+  }
+}
+
+
+/*
+ *  USB Device Bulk In/Out Endpoint Event Callback
+ *    Parameters:      event: USB Device Event
+ *                       USBD_EVT_IN:  Input Event
+ *                       USBD_EVT_OUT: Output Event
+ *    Return Value:    None
+ */
+
+void USBD_BULK_EP_BULK_Event (U32 event) {
+  if (event & USBD_EVT_OUT) {
+    USBD_BULK_EP_BULKOUT_Event (event);
+  }
+  if (event & USBD_EVT_IN) {
+    USBD_BULK_EP_BULKIN_Event (event);
+  }
+}
+
+
+/*
+ *  USB Device Bulk SWO Trace Send Next Packet
+ *   Trace data is sent one packet at a time straight from the user buffer.
+ *   A full packet without more data is followed by a zero length packet so
+ *   the host does not wait for the rest of the transfer.
+ *    Parameters:      None
+ *    Return Value:    None
+ */
+
+static void USBD_BULK_SwoNext (void) {
+  U16 mps;
+  U8 *buf;
+  int len;
+
+  mps = usbd_bulk_maxpacketsize[USBD_HighSpeed];
+  buf = NULL;
+  len = usbd_bulk_swo_get_inbuf (&buf, mps);  /* Release sent data, get next  */
+  if (len || BulkSwoZLP) {
+    BulkSwoZLP    = (len == mps);
+    BulkSwoActive = __TRUE;
+    USBD_WriteEP(usbd_bulk_ep_swoin | 0x80, buf, len);
+  }
+}
+
+
+/*
+ *  USB Device Bulk SWO Trace In Endpoint Event Callback
+ *    Parameters:      event: not used (just for compatibility)
+ *    Return Value:    None
+ */
+
+void USBD_BULK_EP_SWOIN_Event (U32 event) {
+  BulkSwoActive = __FALSE;
+  USBD_BULK_SwoNext ();
+}
+
+
+/*
+ *  USB Device Bulk Event Send Next Packet
+ *   Event packets are short and sent one at a time from the user buffer.
+ *    Parameters:      None
+ *    Return Value:    None
+ */
+
+static void USBD_BULK_EventNext (void) {
+  U8 *buf;
+  int len;
+
+  buf = NULL;
+  len = usbd_bulk_event_get_inbuf (&buf, usbd_bulk_maxpacketsize[0]);
+  if (len) {                            /* Release sent event, get next one   */
+    BulkEventActive = __TRUE;
+    USBD_WriteEP(usbd_bulk_ep_eventin | 0x80, buf, len);
+  }
+}
+
+
+/*
+ *  USB Device Bulk Event In Endpoint Event Callback
+ *    Parameters:      event: not used (just for compatibility)
+ *    Return Value:    None
+ */
+
+void USBD_BULK_EP_EVENTIN_Event (U32 event) {
+  BulkEventActive = __FALSE;
+  USBD_BULK_EventNext ();
+}
+
+
+/*
+ *  USB Device Bulk SOF Handler
+ *   Receives packets left in the out endpoint while no buffer was available
+ *   and restarts the trace and event endpoints when new data is available
+ *    Parameters:      None
+ *    Return Value:    None
+ */
+
+void USBD_BULK_SOF_Event (void) {
+  U8 n;
+
+  if (USBD_Configuration) {
+    n = BulkOutPending;
+    BulkOutPending = 0;
+    while (n--) {
+      USBD_BULK_EP_BULKOUT_Event (0);
+    }
+    if (usbd_bulk_ep_swoin && !BulkSwoActive) {
+      USBD_BULK_SwoNext ();
+    }
+    if (usbd_bulk_ep_eventin && !BulkEventActive) {
+      USBD_BULK_EventNext ();
+    }
+  }
+}
+
+
+/*
+ *  USB Device Bulk Configure Callback
+ *    Parameters:      None
+ *    Return Value:    None
+ */
+
+void USBD_BULK_Configure_Event (void) {
+
+  /* Reset all variables after connect event */
+  BulkInPtr      = NULL;
+  BulkInLen      = 0;
+  BulkInZLP      = __FALSE;
+  BulkInActive   = __FALSE;
+  BulkOutPtr     = NULL;
+  BulkOutLen     = 0;
+  BulkOutPending = 0;
+  BulkSwoActive  = __FALSE;
+  BulkSwoZLP     = __FALSE;
+  BulkEventActive = __FALSE;
+
+  usbd_bulk_init ();
+}
+
+
+/*
+ *  USB Device Bulk Send (start transfer to host without copy)
+ *   Buffer must stay valid until the next usbd_bulk_get_inbuf callback
+ *    Parameters:      buf: Pointer to data buffer
+ *                     len: Number of bytes to be sent
+ *    Return Value:    TRUE - Success, FALSE - Error (not configured or busy)
+ */
+
+BOOL usbd_bulk_send (U8 *buf, int len) {
+
+  if (!USBD_Configuration || BulkInActive || (len > usbd_bulk_max_transfer))
+    return (__FALSE);
+
+  USBD_BULK_StartIn (buf, len);
+  return (__TRUE);
+}
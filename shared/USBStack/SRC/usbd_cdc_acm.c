@@ -28,6 +28,7 @@
 int32_t  data_send_access;              /*!< Flag active while send data (in the send intermediate buffer) is being accessed */
 int32_t  data_send_active;              /*!< Flag active while data is being sent */
 int32_t  data_send_zlp;                 /*!< Flag active when ZLP needs to be sent */
+int32_t  data_send_direct;              /*!< Number of bytes being sent directly from the send intermediate buffer */
 int32_t  data_to_send_wr;               /*!< Number of bytes written to the send intermediate buffer */
 int32_t  data_to_send_rd;               /*!< Number of bytes read from the send intermediate buffer */
 uint8_t *ptr_data_to_send;              /*!< Pointer to the send intermediate buffer to the data to be sent */
@@ -130,6 +131,7 @@ __weak int32_t USBD_CDC_ACM_Reset (void) {
   data_send_access            = 0;
   data_send_active            = 0;
   data_send_zlp               = 0;
+  data_send_direct            = 0;
   data_to_send_wr             = 0;
   data_to_send_rd             = 0;
   ptr_data_to_send            = USBD_CDC_ACM_SendBuf;
@@ -521,7 +523,9 @@ static void USBD_CDC_ACM_EP_BULKOUT_HandleData () {
     The function handles data to be sent on the Bulk In endpoint. It transmits
     pending data to be sent that is already in the send intermediate buffer,
     and it also sends Zero Length Packet if last packet sent was not a short
-    packet.
+    packet. Data for more than one packet is sent directly from the send
+    intermediate buffer when the hardware supports it; that data is released
+    only when its transfer is finished.
  */
 
 static void USBD_CDC_ACM_EP_BULKIN_HandleData (void) {
@@ -530,6 +534,14 @@ static void USBD_CDC_ACM_EP_BULKIN_HandleData (void) {
   if (!data_send_active)                /* If sending is not active           */
     return;
 
+  if (data_send_direct) {               /* If direct transfer finished        */
+    ptr_data_sent    += data_send_direct;   /* Release sent data              */
+    data_to_send_rd  += data_send_direct;
+    if (ptr_data_sent == USBD_CDC_ACM_SendBuf + usbd_cdc_acm_sendbuf_sz)
+      ptr_data_sent = USBD_CDC_ACM_SendBuf;
+    data_send_direct  = 0;
+  }
+
   len_to_send = data_to_send_wr - data_to_send_rd;  /* Num of data to send    */
 
   /* Check if sending is finished                                             */
@@ -557,6 +569,13 @@ static void USBD_CDC_ACM_EP_BULKIN_HandleData (void) {
     if (len_to_send > usbd_cdc_acm_maxpacketsize1[USBD_HighSpeed]) {  /* If
                                            there is more data to be sent then
                                            can be sent in a single packet     */
+      if (USBD_WriteEPDirect(usbd_cdc_acm_ep_bulkin | 0x80, ptr_data_sent, len_to_send)) {
+                                        /* Sent directly, release when done   */
+        data_send_direct = len_to_send;
+        data_send_zlp    = ((data_to_send_wr - data_to_send_rd) == len_to_send) &&
+                           ((len_to_send % usbd_cdc_acm_maxpacketsize1[USBD_HighSpeed]) == 0);
+        return;
+      }
                                         /* Correct to send maximum pckt size  */
       len_to_send = usbd_cdc_acm_maxpacketsize1[USBD_HighSpeed];
     }
@@ -107,6 +107,20 @@ BOOL usbd_configured (void) {
 }
 
 
+/*
+ *  Write USB Device Endpoint Data without copy (multi-packet transfer)
+ *   Default for hardware which sends one packet per USBD_WriteEP call
+ *    Parameters:      EPNum: Endpoint Number
+ *                     pData: Pointer to Data Buffer
+ *                     cnt:   Number of bytes to write
+ *    Return Value:    Number of bytes written (0 = not supported)
+ */
+
+__weak U32 USBD_WriteEPDirect (U32 EPNum, U8 *pData, U32 cnt) {
+  return (0);
+}
+
+
 /*
  *  USB Device Request - Setup Stage
  *    Parameters:      None
@@ -382,6 +396,14 @@ __inline BOOL USBD_ReqGetDescriptor (void) {
           USBD_EP0Data.pData = pD;
           len = ((USB_STRING_DESCRIPTOR *)pD)->bLength;
           break;
+        case USB_BOS_DESCRIPTOR_TYPE:
+          pD = (U8 *)USBD_BOSDescriptor;
+          if (((USB_BOS_DESCRIPTOR *)pD)->bLength == 0) {
+            return (__FALSE);  /* BOS descriptor not provided */
+          }
+          USBD_EP0Data.pData = pD;
+          len = ((USB_BOS_DESCRIPTOR *)pD)->wTotalLength;
+          break;
         default:
           return (__FALSE);
       }
@@ -403,6 +425,35 @@ __inline BOOL USBD_ReqGetDescriptor (void) {
 }
 
 
+/*
+ *  Get Microsoft OS 2.0 Descriptor Set USB Vendor Request
+ *    Parameters:      None
+ *    Return Value:    TRUE - Success, FALSE - Error
+ */
+
+__inline BOOL USBD_ReqGetMSOS20Descriptor (void) {
+  U32  len;
+
+  if ((usbd_msos20_vendor_code == 0)                                         ||
+      (USBD_SetupPacket.bmRequestType.Dir       != REQUEST_DEVICE_TO_HOST)   ||
+      (USBD_SetupPacket.bmRequestType.Recipient != REQUEST_TO_DEVICE)        ||
+      (USBD_SetupPacket.bRequest != usbd_msos20_vendor_code)                 ||
+      (USBD_SetupPacket.wIndex   != MS_OS_20_DESCRIPTOR_INDEX)) {
+    return (__FALSE);
+  }
+
+  USBD_EP0Data.pData = (U8 *)USBD_MSOS20Descriptor;
+  len = USBD_MSOS20Descriptor[8] | (USBD_MSOS20Descriptor[9] << 8);   /* wTotalLength */
+
+  if (USBD_EP0Data.Count > len) {
+    USBD_EP0Data.Count = len;
+    if (!(USBD_EP0Data.Count & (usbd_max_packet0 - 1))) USBD_ZLP = 1;
+  }
+
+  return (__TRUE);
+}
+
+
 /*
  *  Get Configuration USB Device Request
  *    Parameters:      None
@@ -784,6 +835,13 @@ void USBD_EndPoint0 (U32 event) {
 setup_class_ok:                                                          /* request finished successfully */
         break;  /* end case REQUEST_CLASS */
 
+      case REQUEST_VENDOR:
+        if (!USBD_ReqGetMSOS20Descriptor()) {
+          goto stall;
+        }
+        USBD_DataInStage();
+        break;  /* end case REQUEST_VENDOR */
+
       default:
 stall:  if ((USBD_SetupPacket.bmRequestType.Dir == REQUEST_HOST_TO_DEVICE) &&
             (USBD_SetupPacket.wLength != 0)) {
@@ -30,6 +30,7 @@ BOOL         DataOutEndWithShortPacket;
 
 U8          *ptrDataIn;
 U16          DataInReceLen;
+U8           DataInPendingPckts;
 
 U8          *ptrDataFeat;
 U16          DataFeatReceLen;
@@ -41,6 +42,8 @@ __weak int   usbd_hid_get_report   (U8  rtype, U8 rid, U8 *buf, U8  req)
 __weak void  usbd_hid_set_report   (U8  rtype, U8 rid, U8 *buf, int len, U8 req) {};
 __weak U8    usbd_hid_get_protocol (void)                                        { return (0); };
 __weak void  usbd_hid_set_protocol (U8  protocol)                                {};
+__weak int   usbd_hid_get_report_buf    (U8 **buf)                                { return (0); };
+__weak U8   *usbd_hid_get_outreport_buf (void)                                    { return (USBD_HID_OutReport); };
 
 
 /*
@@ -176,13 +179,18 @@ void USBD_HID_EP_INTIN_Event (U32 event) {
       !DataOutEndWithShortPacket) {     /* If all sent and short packet also  */
     ptrDataOut          = NULL;
     DataOutSentLen      = 0;
-    DataOutToSendLen    = usbd_hid_get_report (HID_REPORT_INPUT, USBD_HID_InReport[0], &USBD_HID_InReport[1], USBD_HID_REQ_EP_INT);
-    if (DataOutToSendLen) {             /* If new send should be started      */
-      ptrDataOut        = USBD_HID_InReport;
-      if (usbd_hid_inreport_num <= 1)   /* If only in 1 report skip ReportID  */
-        ptrDataOut++;
-      else                              /* If more in reports, send ReportID  */
-        DataOutToSendLen++;
+    DataOutToSendLen    = 0;
+    if (usbd_hid_inreport_num <= 1)     /* If only 1 report try user buffer   */
+      DataOutToSendLen  = usbd_hid_get_report_buf (&ptrDataOut);
+    if (!DataOutToSendLen) {            /* If no user buffer use InReport     */
+      DataOutToSendLen  = usbd_hid_get_report (HID_REPORT_INPUT, USBD_HID_InReport[0], &USBD_HID_InReport[1], USBD_HID_REQ_EP_INT);
+      if (DataOutToSendLen) {           /* If new send should be started      */
+        ptrDataOut      = USBD_HID_InReport;
+        if (usbd_hid_inreport_num <= 1) /* If only in 1 report skip ReportID  */
+          ptrDataOut++;
+        else                            /* If more in reports, send ReportID  */
+          DataOutToSendLen++;
+      }
     }
   }
   /* Check if new data out sending should be started                          */
@@ -249,8 +257,14 @@ void USBD_HID_EP_INTOUT_Event (U32 event) {
   U16 bytes_rece;
 
   if (!DataInReceLen) {                 /* Check if new reception             */
-    ptrDataIn     = USBD_HID_OutReport;
-    DataInReceLen = 0;
+    if (usbd_hid_outreport_num <= 1)    /* If only 1 report receive into user */
+      ptrDataIn   = usbd_hid_get_outreport_buf ();
+    else
+      ptrDataIn   = USBD_HID_OutReport;
+    if (ptrDataIn == NULL) {            /* If no user buffer leave packet in  */
+      DataInPendingPckts++;             /* endpoint (NAK) and receive it from */
+      return;                           /* SOF when buffer is available       */
+    }
   }
   bytes_rece      = USBD_ReadEP(usbd_hid_ep_intout, ptrDataIn);
   ptrDataIn      += bytes_rece;
@@ -259,7 +273,7 @@ void USBD_HID_EP_INTOUT_Event (U32 event) {
       (DataInReceLen >= usbd_hid_outreport_max_sz) ||
       (bytes_rece    <  usbd_hid_maxpacketsize[USBD_HighSpeed])) {
     if (usbd_hid_outreport_num <= 1) {  /* If only one out report in system   */
-      usbd_hid_set_report (HID_REPORT_OUTPUT,                    0 ,  USBD_HID_OutReport   , DataInReceLen,   USBD_HID_REQ_EP_INT);
+      usbd_hid_set_report (HID_REPORT_OUTPUT,                    0 ,  ptrDataIn - DataInReceLen, DataInReceLen, USBD_HID_REQ_EP_INT);
     } else {
       usbd_hid_set_report (HID_REPORT_OUTPUT, USBD_HID_OutReport[0], &USBD_HID_OutReport[1], DataInReceLen-1, USBD_HID_REQ_EP_INT);
     }
@@ -288,6 +302,7 @@ void USBD_HID_Configure_Event (void) {
 
   ptrDataIn                 = NULL;
   DataInReceLen             = 0;
+  DataInPendingPckts        = 0;
 
   ptrDataFeat               = NULL;
   DataFeatReceLen           = 0;
@@ -325,6 +340,12 @@ void USBD_HID_SOF_Event (void) {
          BOOL tick_4ms, do_polling, polling_reload, idle_reload;
 
   if (USBD_Configuration) {
+    i = DataInPendingPckts;             /* Retry packets left in out endpoint */
+    DataInPendingPckts = 0;
+    while (i--) {
+      USBD_HID_EP_INTOUT_Event (0);
+    }
+
     tick_4ms = __FALSE;
     if (cnt_for_4ms++ >= ((4 << (3 * USBD_HighSpeed))) - 1) {
       cnt_for_4ms = 0;
@@ -443,7 +464,7 @@ __task void USBD_RTX_HID_EP_INT_Event (void) {
  *    Parameters:      rid: Report ID
  *                     buf: Pointer to data buffer
  *                     len: Number of bytes to be sent
- *    Return Value:    TRUE - Success, FALSE - Error
+ *    Return Value:    TRUE - Success, FALSE - Error (not configured or busy)
  */
 
 BOOL usbd_hid_get_report_trigger (U8 rid, U8 *buf, int len) {
@@ -452,16 +473,9 @@ BOOL usbd_hid_get_report_trigger (U8 rid, U8 *buf, int len) {
     return (__FALSE);
 
   if (USBD_Configuration) {
+    if (DataOutToSendLen)               /* If report is being sent reject rq  */
+      return (__FALSE);
     DataOutAsyncReq    = __TRUE;        /* Asynchronous data out request      */
-    while (DataOutToSendLen) {
-      if (!USBD_Configuration) {        /* If device not configured reject rq */
-        DataOutAsyncReq    = __FALSE;   /* Asynchronous data out request      */
-        ptrDataOut         = NULL;
-        DataOutSentLen     = 0;
-        DataOutToSendLen   = 0;
-        return (__FALSE);
-      }
-    }
     USBD_HID_InReport[0]   = rid;
     memcpy (&USBD_HID_InReport[1], buf, len);
     ptrDataOut             = USBD_HID_InReport;
@@ -478,3 +492,33 @@ BOOL usbd_hid_get_report_trigger (U8 rid, U8 *buf, int len) {
 
   return (__FALSE);
 }
+
+
+/*
+ *  USB Device HID Send Report (asynchronous Get_Report request without copy)
+ *   Only for single input report; buffer must stay valid until the next
+ *   usbd_hid_get_report_buf callback
+ *    Parameters:      buf: Pointer to data buffer
+ *                     len: Number of bytes to be sent
+ *    Return Value:    TRUE - Success, FALSE - Error (not configured or busy)
+ */
+
+BOOL usbd_hid_send_report (U8 *buf, int len) {
+
+  if ((len > usbd_hid_inreport_max_sz) || (usbd_hid_inreport_num > 1))
+    return (__FALSE);
+
+  if (USBD_Configuration) {
+    if (DataOutToSendLen)               /* If report is being sent reject rq  */
+      return (__FALSE);
+    DataOutAsyncReq    = __TRUE;        /* Asynchronous data out request      */
+    ptrDataOut             = buf;
+    DataOutSentLen         = 0;
+    DataOutToSendLen       = len;
+    USBD_HID_EP_INTIN_Event (0);
+    USBD_HID_IdleCnt[0]    = 0;
+    return (__TRUE);
+  }
+
+  return (__FALSE);
+}